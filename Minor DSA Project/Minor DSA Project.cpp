@@ -1,17 +1,71 @@
 ﻿/* * Controls:
- *   1 – 6      Select algorithm        SPACE   Start / Pause
+ *   1 – 9, 0   Select algorithm        SPACE   Start / Pause
+ *   LEFT/RIGHT Previous / next algorithm   H   Binary / 4-ary heap
+ *   P / O      Quick Sort pivot rule / partition scheme
+ *   I / L      Intro Sort insertion cutoff / depth limit
+ *   K / J / U  External Sort fan-in / run size / run sort
+ *   B          Bitonic Sort on the GPU / CPU (-DSORTVIS_GPU, OpenGL 4.3)
+ *   M          Memory probe on / off    N   Run native + hardware counters
+ *   T          Dry-run table of every algorithm on this input
+ *   F          Frame profiler on / off  X   Write its Chrome trace
  *   R          Shuffle & reset         UP / DOWN   Speed
+ *   G          Input pattern (same seed)
  *   A / D      Array size  ↓ / ↑
+ *   C          Events per step  1 / 4 / 16 / 64 / 256
+ *   V          Race mode (1 – 9, 0 / ENTER pick the lanes)
+ *   , / .      Step the replay back / forward (drag the progress bar to scrub)
 */
 
 #include "raylib.h"
+#include "rlgl.h"
 #include <vector>
 #include <numeric>
 #include <algorithm>
 #include <random>
-#include <functional>
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <cctype>
+#include <tuple>
+#include <type_traits>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Bitonic Sort's compute path is built with -DSORTVIS_GPU (see GpuBitonic)
+#if defined(SORTVIS_GPU)
+static const bool GPU_BUILT = true;
+#else
+static const bool GPU_BUILT = false;
+#endif
 
  
  //  Layout constants
@@ -29,10 +83,29 @@ static const int BOT_PAD = 18;
 static const int BAR_AREA_Y = PANEL_H;
 static const int BAR_AREA_H = SH - PANEL_H - BOT_PAD;
 
-// Selectable array sizes  (A / D cycle through these)
-static const int SIZE_OPTIONS[] = { 25, 50, 75, 100, 150, 200 };
-static const int SIZE_COUNT = 6;
+static const int TARGET_FPS = 60;
+
+// Selectable array sizes  (A / D cycle through these).  From 1000 up the
+// bars no longer fit one per slot and the column view takes over.
+static const int SIZE_OPTIONS[] = {
+    25, 50, 75, 100, 150, 200,
+    1000, 10000, 100000, 1000000, 10000000
+};
+static const int SIZE_COUNT = 11;
+
+// Events grouped into one replay step  (C cycles through these)
+static const int GROUP_OPTIONS[] = { 1, 4, 16, 64, 256 };
+static const int GROUP_COUNT = 5;
+
+
+// Column view: values are summarised in blocks of 2^BLOCK_SHIFT bars
+static const int BLOCK_SHIFT = 6;
+
+// Bar width once n bars and their gaps share the screen
+static int slotWidth(int n) { return (SW - BAR_GAP * (n + 1)) / n; }
 
+// Too many bars for a slot each: draw one aggregated column per pixel
+static bool columnMode(int n) { return slotWidth(n) < 2; }
 
 //  Colour palette
 
@@ -68,6 +141,15 @@ enum Algorithm {
     MERGE,
     QUICK,
     HEAP,
+    PARALLEL_MERGE,
+    PARALLEL_QUICK,
+    RADIX,
+    COUNTING,
+    BUCKET,
+    INTRO,
+    TIM,
+    EXTERNAL,
+    BITONIC,
     ALGO_COUNT
 };
 
@@ -77,12 +159,60 @@ static const char* ALGO_NAMES[ALGO_COUNT] = {
     "Insertion Sort",
     "Merge Sort",
     "Quick Sort",
-    "Heap Sort"
+    "Heap Sort",
+    "Parallel Merge",
+    "Parallel Quick",
+    "Radix Sort",
+    "Counting Sort",
+    "Bucket Sort",
+    "Intro Sort",
+    "TimSort",
+    "External Sort",
+    "Bitonic Sort"
 };
 
 static const char* ALGO_CMPLX[ALGO_COUNT] = {
     "O(n²)", "O(n²)", "O(n²)",
-    "O(n log n)", "O(n log n)", "O(n log n)"
+    "O(n log n)", "O(n log n)", "O(n log n)",
+    "O(n log n)", "O(n log n)",
+    "O(d(n+b))", "O(n+k)", "O(n+k)",
+    "O(n log n)", "O(n log n)", "O(n log n)",
+    "O(n log² n)"
+};
+
+static bool isParallel(Algorithm a)
+{
+    return a == PARALLEL_MERGE || a == PARALLEL_QUICK;
+}
+
+static bool isQuadratic(Algorithm a)
+{
+    return a == BUBBLE || a == SELECTION || a == INSERTION;
+}
+
+// Distribution sorts that index by key value, so need integer keys
+static bool isIntegerKey(Algorithm a)
+{
+    return a == RADIX || a == COUNTING || a == BUCKET;
+}
+
+// O(n²) algorithms are not run natively above this size (minutes beyond)
+static const int QUAD_LIMIT = 20000;
+
+// Worker colour lanes for the parallel engines (lane 1 … MAX_LANES)
+static const int MAX_LANES = 8;
+
+static const Color C_LANE_HI[MAX_LANES] = {
+    { 255, 120, 200, 255 }, { 110, 230, 255, 255 },
+    { 255, 170,  80, 255 }, { 185, 135, 255, 255 },
+    { 120, 255, 160, 255 }, { 255, 235, 110, 255 },
+    { 255, 110, 110, 255 }, { 160, 205, 255, 255 },
+};
+static const Color C_LANE_LO[MAX_LANES] = {
+    { 170,  60, 130, 255 }, {  40, 150, 180, 255 },
+    { 180, 100,  30, 255 }, { 115,  70, 190, 255 },
+    {  50, 170,  90, 255 }, { 180, 160,  40, 255 },
+    { 180,  50,  50, 255 }, {  80, 125, 190, 255 },
 };
 
 
@@ -91,808 +221,7808 @@ static const char* ALGO_CMPLX[ALGO_COUNT] = {
 
 struct AnimState {
     // Shuffle wave — bars pop in left-to-right over ~0.7 s
+    // (each bar's delay is its normalised position i / n)
     bool               shuffleActive = false;
     float              shuffleTimer = 0.f;   // 0 → 1 (wave progress)
-    std::vector<float> waveOffset;            // per-bar normalised delay
 
     // Fanfare sweep — bright highlight sweeps left→right on completion
     bool  fanfareActive = false;
     float fanfarePos = 0.f;               // current bar index reached
 };
 
-//  Sort state
+//  Trace events
+//
+//  Engines run the algorithm on a private copy of the bars and describe
+//  what happened as small, trivially-copyable events.  applyOp() replays
+//  one event against the live SortState.
+
+enum OpKind : unsigned char {
+    OP_COMPARE = 0,   // a, b  — highlight a pair, count a comparison
+    OP_SWAP,          // a, b  — exchange bars[a] and bars[b]
+    OP_WRITE,         // a = index, b = value
+    OP_SORTED,        // a .. b (inclusive) reached its final position
+    OP_READ,          // a     — highlight a bar being read (no counter)
+    OP_LOAD,          // a .. b copied into a scratch buffer (not drawn)
+    OP_MARK_INSERTION,  // a .. b handed to the insertion fallback (Intro)
+    OP_MARK_HEAP,       // a .. b handed to the heap fallback (Intro)
+    OP_MARK_RUN,        // a .. b is one sorted run on the stack (TimSort)
+    OP_MARK_MERGE       // a .. b is being k-way merged (External)
+};
 
-struct SortState {
-    std::vector<int> bars;
-    std::vector<int> colorMap;   // 0 default · 1 compare · 2 swap · 3 sorted
+struct Op {
+    OpKind        kind;
+    unsigned char lane;   // 0 = single-threaded, else worker lane 1 … 8
+    int           a;
+    int           b;
+};
 
-    Algorithm  algo = BUBBLE;
-    bool       running = false;
-    bool       finished = false;
-    int        speed = 5;     // 1 (slow) … 10 (fast)
-    int        sizeIdx = 3;     // index into SIZE_OPTIONS  (default 100)
-    long long  comparisons = 0;
-    long long  swaps = 0;
+//  Run arena
+//
+//  Everything an engine allocates (its working copy, scratch buffers and
+//  stacks, the parallel engines' recorded trace) comes from one monotonic
+//  arena that is released in one go when the next run is built.  Nothing
+//  is freed inside a run: a vector that grows leaves its old block behind,
+//  which at most doubles what it holds.  The first chunk is sized from the
+//  array, so a run takes a handful of system allocations however many
+//  buffers the engine makes.
+
+using IntBuf = std::pmr::vector<int>;
+
+// Counts what the arena takes from the system.  Thread-safe: each lane of
+// a parallel recording grows its own sub-arena from it
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::atomic<size_t>    bytes{ 0 };
+    std::atomic<long long> allocs{ 0 };
+
+private:
+    void* do_allocate(size_t n, size_t align) override
+    {
+        bytes.fetch_add(n, std::memory_order_relaxed);
+        allocs.fetch_add(1, std::memory_order_relaxed);
+        return std::pmr::new_delete_resource()->allocate(n, align);
+    }
 
-    std::vector<std::function<void()>> steps;
-    size_t stepIdx = 0;
+    void do_deallocate(void* p, size_t n, size_t align) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, n, align);
+    }
 
-    int barCount() const { return SIZE_OPTIONS[sizeIdx]; }
+    bool do_is_equal(const memory_resource& o) const noexcept override
+    {
+        return this == &o;
+    }
 };
 
-//  Utility helpers
+class RunArena {
+public:
+    RunArena() { reset(0); }
 
-static void resetColors(SortState& s)
-{
-    std::fill(s.colorMap.begin(), s.colorMap.end(), 0);
-}
+    // Drop the last run's memory; the first chunk holds `hint` bytes.
+    // Every engine built from the arena must be gone by now
+    void reset(size_t hint)
+    {
+        pool.reset();
+        sys.bytes = 0;
+        sys.allocs = 0;
+        pool.emplace(std::max<size_t>(hint, 4096), &sys);
+    }
 
-// Linear colour interpolation
-static Color lerpCol(Color a, Color b, float t)
-{
-    return {
-        (unsigned char)(a.r + (b.r - a.r) * t),
-        (unsigned char)(a.g + (b.g - a.g) * t),
-        (unsigned char)(a.b + (b.b - a.b) * t),
-        255
-    };
-}
+    std::pmr::memory_resource* resource() { return &*pool; }
+    std::pmr::memory_resource* upstream() { return &sys; }
 
-// Shuffle bars and kick off the wave pop-in animation
-static void shuffle(SortState& s, AnimState& anim)
-{
-    static std::mt19937 rng(std::random_device{}());
+    size_t    bytes() const { return sys.bytes.load(std::memory_order_relaxed); }
+    long long allocs() const { return sys.allocs.load(std::memory_order_relaxed); }
 
-    int n = s.barCount();
-    s.bars.assign(n, 0);
-    s.colorMap.assign(n, 0);
+    // First chunk for n keys: the working copy plus as much scratch
+    static size_t hintFor(size_t n) { return 2 * n * sizeof(int) + 16384; }
 
-    std::iota(s.bars.begin(), s.bars.end(), 1);
-    std::shuffle(s.bars.begin(), s.bars.end(), rng);
+private:
+    CountingResource sys;
+    std::optional<std::pmr::monotonic_buffer_resource> pool;
+};
 
-    s.running = false;
-    s.finished = false;
-    s.comparisons = 0;
-    s.swaps = 0;
-    s.steps.clear();
-    s.stepIdx = 0;
+//  Step engine
+//
+//  Each algorithm is a resumable state machine: step() advances it by one
+//  loop iteration and emit()s the events that iteration produced.  next()
+//  hands events out one at a time, so nothing is generated until the
+//  replay loop asks for it and memory stays O(n) for every algorithm.
 
-    // Stagger each bar's pop-in by its normalised position
-    anim.shuffleActive = true;
-    anim.shuffleTimer = 0.f;
-    anim.waveOffset.resize(n);
-    for (int i = 0; i < n; i++)
-        anim.waveOffset[i] = (float)i / n;
+struct Engine {
+    virtual ~Engine() = default;
 
-    anim.fanfareActive = false;
-}
+    // Produce the next event; false once the run is complete
+    bool next(Op& op)
+    {
+        while (pendHead == pendCount) {
+            pendHead = pendCount = 0;
+            if (done) return false;
+            if (!step()) {
+                emit(OP_SORTED, 0, (int)a.size() - 1);
+                done = true;
+            }
+        }
+        op = pend[pendHead++];
+        return true;
+    }
 
-//  Sort builders — each pre-generates all steps as lambdas
+    // Rough fraction of the total work completed (drives the progress bar)
+    virtual float progress() const = 0;
 
-// ── Bubble Sort ────────
-static void buildBubble(SortState& s)
-{
-    int n = s.barCount();
+    // Scratch memory held beyond the working copy of the array
+    virtual size_t auxBytes() const { return 0; }
 
-    for (int i = 0; i < n - 1; i++) {
-        for (int j = 0; j < n - 1 - i; j++) {
-            s.steps.push_back([&s, j, i, n]() {
-                resetColors(s);
-                s.colorMap[j] = 1;
-                s.colorMap[j + 1] = 1;
-                s.comparisons++;
-
-                if (s.bars[j] > s.bars[j + 1]) {
-                    std::swap(s.bars[j], s.bars[j + 1]);
-                    s.colorMap[j] = 2;
-                    s.colorMap[j + 1] = 2;
-                    s.swaps++;
-                }
+protected:
+    Engine(const std::vector<int>& bars, std::pmr::memory_resource* mr)
+        : a(bars.begin(), bars.end(), mr) {}
 
-                for (int k = n - i - 1; k < n; k++)
-                    s.colorMap[k] = 3;
-                });
-        }
+    // Arena the run allocates from (members: `IntBuf buf{ mem() };`)
+    std::pmr::memory_resource* mem() const
+    {
+        return a.get_allocator().resource();
     }
 
-    s.steps.push_back([&s, n]() {
-        for (int k = 0; k < n; k++) s.colorMap[k] = 3;
-        });
-}
-
-// ── Selection Sort ───────────────────
-static void buildSelection(SortState& s)
-{
-    int n = s.barCount();
-
-    for (int i = 0; i < n - 1; i++) {
-        s.steps.push_back([&s, i, n]() mutable {
-            resetColors(s);
-            int mi = i;
-            s.colorMap[i] = 2;
-
-            for (int j = i + 1; j < n; j++) {
-                s.comparisons++;
-                s.colorMap[j] = 1;
-                if (s.bars[j] < s.bars[mi]) {
-                    if (mi != i) s.colorMap[mi] = 0;
-                    mi = j;
-                    s.colorMap[mi] = 2;
-                }
-            }
+    // One loop iteration; false when the algorithm has finished
+    virtual bool step() = 0;
 
-            if (mi != i) {
-                std::swap(s.bars[i], s.bars[mi]);
-                s.swaps++;
-            }
+    void emit(OpKind k, int x, int y) { pend[pendCount++] = { k, 0, x, y }; }
+    void emit(const Op& op) { pend[pendCount++] = op; }
 
-            for (int k = 0; k <= i; k++) s.colorMap[k] = 3;
-            });
+    // Callable that forwards to emit(), for the range passes below
+    auto sink()
+    {
+        return [this](OpKind k, int x, int y) { emit(k, x, y); };
     }
 
-    s.steps.push_back([&s, n]() {
-        for (int k = 0; k < n; k++) s.colorMap[k] = 3;
-        });
-}
+    IntBuf a;             // private working copy
 
-// ── Insertion Sort ───────────
-static void buildInsertion(SortState& s)
-{
-    int n = s.barCount();
+private:
+    Op   pend[16];    // one step emits at most 13 (ninther pivot + swap)
+    int  pendHead = 0;
+    int  pendCount = 0;
+    bool done = false;
+};
 
-    for (int i = 1; i < n; i++) {
-        s.steps.push_back([&s, i]() {
-            resetColors(s);
-            int key = s.bars[i];
-            int j = i - 1;
-            s.colorMap[i] = 2;
-
-            while (j >= 0 && s.bars[j] > key) {
-                s.bars[j + 1] = s.bars[j];
-                s.colorMap[j + 1] = 1;
-                j--;
-                s.comparisons++;
-                s.swaps++;
-            }
+// Quick Sort variants (P / O in the window, --pivot / --partition)
+enum PivotRule : unsigned char {
+    PIVOT_LAST = 0, PIVOT_MEDIAN3, PIVOT_NINTHER, PIVOT_COUNT
+};
+enum PartitionScheme : unsigned char {
+    PART_LOMUTO = 0, PART_BRANCHLESS, PART_HOARE, PART_BLOCK, PART_COUNT
+};
 
-            s.bars[j + 1] = key;
-            s.colorMap[j + 1] = 2;
-            });
-    }
+static const char* PIVOT_NAMES[PIVOT_COUNT] = {
+    "last", "median3", "ninther"
+};
+static const char* PART_NAMES[PART_COUNT] = {
+    "lomuto", "branchless", "hoare", "simd"
+};
 
-    s.steps.push_back([&s, n]() {
-        for (int k = 0; k < n; k++) s.colorMap[k] = 3;
-        });
-}
+static const int NINTHER_MIN = 40;    // smaller ranges use median-of-3
+static const int PART_BLOCK_W = 8;    // keys per vector in the block scheme
+
+// Per-run engine settings chosen in the UI (or on the --bench line)
+struct EngineOptions {
+    int             heapArity = 2;    // children per heap node: 2 or 4
+    PivotRule       pivot = PIVOT_LAST;
+    PartitionScheme partition = PART_LOMUTO;
+    int             introCutoff = 16; // Intro: insertion sort at or below
+    int             introDepth = 2;   // Intro: heap sort past depth·log2 n
+    int             extRunSize = 0;   // External: keys per run (0 = n / 16)
+    int             extFanIn = 4;     // External: runs merged at once, 2 … 16
+    bool            extRunQuick = false;  // External: runs by Quick Sort
+};
 
-// ── Merge Sort (iterative, bottom-up) ──────
-static void buildMerge(SortState& s)
+static const int EXT_AUTO_RUNS = 16;  // runs formed when extRunSize is 0
+static const int EXT_FANIN_MAX = 16;
+
+// Keys per in-memory run for n keys
+static int extRunLen(const EngineOptions& o, int n)
 {
-    int n = s.barCount();
+    int len = o.extRunSize > 0 ? o.extRunSize
+        : (n + EXT_AUTO_RUNS - 1) / EXT_AUTO_RUNS;
+    return std::max(2, std::min(len, std::max(n, 2)));
+}
 
-    for (int w = 1; w < n; w *= 2) {
-        for (int i = 0; i < n; i += 2 * w) {
-            int l = i;
-            int m = std::min(i + w - 1, n - 1);
-            int r = std::min(i + 2 * w - 1, n - 1);
-            if (m >= r) continue;
-
-            s.steps.push_back([&s, l, m, r]() {
-                resetColors(s);
-                std::vector<int> tmp(
-                    s.bars.begin() + l,
-                    s.bars.begin() + r + 1
-                );
-
-                int i2 = 0;
-                int j2 = m - l + 1;
-                int k = l;
-
-                while (i2 <= m - l && j2 <= r - l) {
-                    s.comparisons++;
-                    if (tmp[i2] <= tmp[j2])
-                        s.bars[k++] = tmp[i2++];
-                    else {
-                        s.bars[k++] = tmp[j2++];
-                        s.swaps++;
-                    }
-                }
+// Input patterns (G in the window, --pattern on the --bench line)
+enum InputPattern : unsigned char {
+    PAT_UNIFORM = 0, PAT_SORTED, PAT_REVERSE, PAT_NEARLY, PAT_FEW_UNIQUE,
+    PAT_ORGAN_PIPE, PAT_SAWTOOTH, PAT_ZIPF, PAT_COUNT
+};
 
-                while (i2 <= m - l) s.bars[k++] = tmp[i2++];
-                while (j2 <= r - l) s.bars[k++] = tmp[j2++];
+static const char* PAT_NAMES[PAT_COUNT] = {
+    "uniform", "sorted", "reverse", "nearly", "few-unique",
+    "organ-pipe", "sawtooth", "zipf"
+};
 
-                for (int x = l; x <= r; x++) s.colorMap[x] = 2;
-                });
-        }
-    }
+static const int    FEW_UNIQUE_KEYS = 8;   // distinct values in few-unique
+static const int    SAW_TEETH = 5;         // ascending runs in sawtooth
+static const double ZIPF_S = 1.0;          // Zipf exponent
 
-    s.steps.push_back([&s, n]() {
-        for (int k = 0; k < n; k++) s.colorMap[k] = 3;
-        });
+// Quick Sort inputs that drive partitioning to O(n²): a last-element
+// pivot on presorted runs, and the Lomuto-style schemes on heavy
+// duplicates (Hoare splits equal keys evenly).  Parallel Quick always
+// partitions Lomuto-style around the last element
+static bool degradesOn(Algorithm a, const EngineOptions& o, InputPattern p)
+{
+    if (a == EXTERNAL && o.extRunQuick) a = QUICK;   // as its runs do
+    if (a != QUICK && a != PARALLEL_QUICK) return false;
+    PivotRule       pr = a == QUICK ? o.pivot : PIVOT_LAST;
+    PartitionScheme ps = a == QUICK ? o.partition : PART_LOMUTO;
+
+    bool presorted = p == PAT_SORTED || p == PAT_REVERSE;
+    bool runs = presorted || p == PAT_ORGAN_PIPE || p == PAT_SAWTOOTH;
+    bool dups = p == PAT_FEW_UNIQUE || p == PAT_ZIPF;
+
+    if (ps == PART_HOARE) return pr == PIVOT_LAST && presorted;
+    return (pr == PIVOT_LAST && runs) || dups
+        || (pr == PIVOT_MEDIAN3 && p == PAT_ORGAN_PIPE);
 }
 
-// ── Quick Sort (iterative) ─────────────
-static void buildQuick(SortState& s)
-{
-    int n = s.barCount();
+// What the next shuffle generates.  The same spec and size always give
+// the same array, on every platform
+struct InputSpec {
+    InputPattern pattern = PAT_UNIFORM;
+    unsigned     seed = 1;
+    int          swaps = -1;    // nearly: random swaps (-1 = n / 100)
+};
 
-    struct Range { int l, r; };
+//  Memory instrumentation  (optional, toggled with M)
+//
+//  Counts what each replayed event does to the array: compares and reads
+//  load one or two elements, swaps load and store two, writes store one,
+//  and OP_LOAD bulk-copies a range out.  Each event's distinct 64-byte
+//  lines go through a simulated L1 (32 KiB, 8-way, LRU), so the card can
+//  show how often an algorithm leaves the cache.  Traffic inside engines'
+//  scratch buffers is not simulated; engines report the bytes they hold.
 
-    std::vector<int>   arr = s.bars;
-    std::vector<Range> work;
-    work.push_back({ 0, n - 1 });
+static const int LINE_ELEMS = 64 / sizeof(int);
 
-    while (!work.empty()) {
-        Range wr = work.back();
-        work.pop_back();
+struct CacheSim {
+    static const int SETS = 64;
+    static const int WAYS = 8;
 
-        int l = wr.l;
-        int r = wr.r;
-        if (l >= r) continue;
-
-        int pivot = arr[r];
-        int i2 = l - 1;
-
-        std::vector<int> snap = arr;
-        int sL = l, sR = r;
-
-        s.steps.push_back([&s, snap, sL, sR]() mutable {
-            resetColors(s);
-            int p2 = s.bars[sR];
-            int i3 = sL - 1;
-            s.colorMap[sR] = 2;
-
-            for (int j = sL; j < sR; j++) {
-                s.comparisons++;
-                s.colorMap[j] = 1;
-                if (s.bars[j] <= p2) {
-                    i3++;
-                    std::swap(s.bars[i3], s.bars[j]);
-                    s.colorMap[i3] = 2;
-                    s.swaps++;
-                }
-            }
+    long long          tag[SETS][WAYS];
+    unsigned long long used[SETS][WAYS];
+    unsigned long long tick = 0;
 
-            std::swap(s.bars[i3 + 1], s.bars[sR]);
-            s.colorMap[i3 + 1] = 3;
-            });
+    CacheSim() { clear(); }
 
-        for (int j = l; j < r; j++) {
-            if (arr[j] <= pivot) {
-                i2++;
-                std::swap(arr[i2], arr[j]);
-            }
-        }
+    void clear()
+    {
+        for (int s = 0; s < SETS; s++)
+            for (int w = 0; w < WAYS; w++) { tag[s][w] = -1; used[s][w] = 0; }
+        tick = 0;
+    }
 
-        std::swap(arr[i2 + 1], arr[r]);
-        int p = i2 + 1;
+    // True on a hit; a miss replaces the set's least recently used way
+    bool touch(long long line)
+    {
+        long long*          t = tag[line & (SETS - 1)];
+        unsigned long long* u = used[line & (SETS - 1)];
+        int lru = 0;
+        for (int w = 0; w < WAYS; w++) {
+            if (t[w] == line) { u[w] = ++tick; return true; }
+            if (u[w] < u[lru]) lru = w;
+        }
+        t[lru] = line;
+        u[lru] = ++tick;
+        return false;
+    }
+};
 
-        if (p - 1 > l) work.push_back({ l,     p - 1 });
-        if (p + 1 < r) work.push_back({ p + 1, r });
+struct MemProbe {
+    bool      on = false;
+    long long reads = 0;          // array elements loaded
+    long long writes = 0;         // array elements stored
+    long long lineRefs = 0;       // distinct lines per event, summed
+    long long misses = 0;         // simulated L1 misses
+    long long ops = 0;            // events that touched the array
+    size_t    auxBytes = 0;       // engine scratch held right now
+    size_t    auxPeak = 0;
+    CacheSim  l1;
+
+    void reset()
+    {
+        reads = writes = lineRefs = misses = ops = 0;
+        auxBytes = auxPeak = 0;
+        l1.clear();
     }
 
-    s.steps.push_back([&s, n]() {
-        std::sort(s.bars.begin(), s.bars.end());
-        for (int k = 0; k < n; k++) s.colorMap[k] = 3;
-        });
-}
+    void noteAux(size_t bytes)
+    {
+        auxBytes = bytes;
+        auxPeak = std::max(auxPeak, bytes);
+    }
+};
 
-// ── Heap Sort ───────────────────────────────────
-static void heapify(
-    std::vector<int>& arr,
-    std::vector<std::function<void()>>& steps,
-    std::vector<int>& cm,
-    long long& cc, long long& sc,
-    int n, int i)
-{
-    int lg = i;
-    int l = 2 * i + 1;
-    int r = 2 * i + 2;
+//  Replay history  (scrubbing)
+//
+//  The window keeps every event it replays, with the value each write
+//  overwrote, plus a keyframe of the whole replay state every K events.
+//  Stepping back one event inverts it in place: a swap is its own
+//  inverse, a write puts back the old value, a compare or read only
+//  un-counts.  Any other seek replays forward, from where the replay
+//  stands if that is at most K events away and otherwise from the
+//  nearest keyframe at or before the target.  K is at least n,
+//  so a keyframe costs O(n) and adds about 8 bytes per event whatever the
+//  array size.  Past HIST_MAX_EVENTS the history is dropped and the run
+//  plays forward only.
+
+static const int       HIST_KEY_MIN = 4096;
+static const long long HIST_MAX_EVENTS = 1 << 22;   // ~96 MB at worst
+
+struct Delta {
+    Op  op;
+    int old;                      // OP_WRITE: the value it replaced
+};
 
-    if (l < n) { cc++; if (arr[l] > arr[lg]) lg = l; }
-    if (r < n) { cc++; if (arr[r] > arr[lg]) lg = r; }
+// Everything applyOp() can change, at one point of the replay
+struct Keyframe {
+    std::vector<int> bars;
+    std::vector<int> colorMap;
+    int       lit[MAX_LANES + 1][2];
+    long long comparisons, swaps;
+    float     progress;
+    int       sortedBelow, sortedFrom;
+    OpKind    fallback;
+    int       fallbackLo, fallbackHi, insertionRuns, heapRuns;
+    std::vector<std::pair<int, int>> runs;
+};
 
-    if (lg != i) {
-        std::swap(arr[i], arr[lg]);
-        sc++;
-        int ci = i, cl = lg;
-        steps.push_back([&cm, ci, cl]() {
-            std::fill(cm.begin(), cm.end(), 0);
-            cm[ci] = 2;
-            cm[cl] = 1;
-            });
-        heapify(arr, steps, cm, cc, sc, n, lg);
-    }
-}
+//  Trace files  (--record, --trace)
+//
+//  A run's events can be written once and replayed later straight from
+//  disk.  The file is a fixed header and the initial bars, then the
+//  event stream with a keyframe block in front of every K-th event, then
+//  an index of the keyframes.  Each event is a tag byte (kind | lane << 4)
+//  and two zig-zag varints: `a` relative to the previous event's `a`, and
+//  `b` relative to `a` for index pairs (compare / swap) or to the previous
+//  `b` otherwise — about 3 bytes for a bubble-sort step.  K is 16n (at
+//  least 64k events), so keyframes add well under 1 byte per event.
+//
+//  The window maps the file and decodes it on demand: memory use is the
+//  pages being read, not the trace, and a seek is one keyframe plus at
+//  most K events.  The header, keyframes and index are written raw, in
+//  host byte order (little-endian on every supported target), so a file
+//  only reads back on a host of the same byte order.
+
+static const uint32_t TRACE_VERSION = 2;   // 2: External Sort options
+static const int      TRACE_KEY_MIN = 1 << 16;
+
+struct TraceHeader {
+    char     magic[4];            // "STRC"
+    uint32_t version;
+    uint32_t algo, n;
+    uint32_t pattern, seed;
+    int32_t  swaps;
+    uint8_t  heapArity, pivot, partition, introDepth;
+    int32_t  introCutoff;
+    uint32_t every;               // K
+    int32_t  extRunSize;
+    uint8_t  extFanIn, extRunQuick, pad[2];
+    uint64_t events;
+    uint64_t keys;
+    uint64_t indexOffset;
+};
+static_assert(sizeof(TraceHeader) == 72, "trace header layout");
 
-static void buildHeap(SortState& s)
-{
-    int n = s.barCount();
-    std::vector<int> arr = s.bars;
-
-    // Build max-heap
-    for (int i = n / 2 - 1; i >= 0; i--) {
-        heapify(arr, s.steps, s.colorMap,
-            s.comparisons, s.swaps, n, i);
-        std::vector<int> snap = arr;
-        s.steps.push_back([&s, snap]() {
-            s.bars = snap;
-            resetColors(s);
-            });
-    }
-
-    // Extract elements one by one
-    for (int i = n - 1; i > 0; i--) {
-        std::swap(arr[0], arr[i]);
-        s.swaps++;
+// Index entry: keyframe j sits in front of event j·K
+struct TraceKey {
+    uint64_t keyOffset;           // keyframe block
+    uint64_t streamOffset;        // the event after it
+    int32_t  prevA, prevB;        // decoder state at that point
+};
 
-        std::vector<int> snap = arr;
-        int ss = i;
-        s.steps.push_back([&s, snap, ss, n]() {
-            s.bars = snap;
-            resetColors(s);
-            s.colorMap[0] = 2;
-            for (int k = ss; k < n; k++) s.colorMap[k] = 3;
-            });
-
-        heapify(arr, s.steps, s.colorMap,
-            s.comparisons, s.swaps, i, 0);
-
-        std::vector<int> snap2 = arr;
-        int si2 = i;
-        s.steps.push_back([&s, snap2, si2, n]() {
-            s.bars = snap2;
-            resetColors(s);
-            for (int k = si2; k < n; k++) s.colorMap[k] = 3;
-            });
-    }
-
-    s.steps.push_back([&s, n]() {
-        std::sort(s.bars.begin(), s.bars.end());
-        for (int k = 0; k < n; k++) s.colorMap[k] = 3;
-        });
-}
+// Where a decode stands; `event` is the next event to read
+struct TraceCursor {
+    uint64_t  off = 0;
+    long long event = 0;
+    int       prevA = 0, prevB = 0;
+    uint64_t  nextKey = 0;        // next keyframe block to step over
+};
 
-// ── Dispatcher ─────────────────────
-static void buildSteps(SortState& s)
-{
-    s.steps.clear();
-    s.stepIdx = 0;
-    s.comparisons = 0;
-    s.swaps = 0;
-    resetColors(s);
+static inline bool pairOp(OpKind k) { return k == OP_COMPARE || k == OP_SWAP; }
+
+#if defined(_WIN32)
+// <windows.h> clashes with raylib's names, so declare just what we need
+extern "C" __declspec(dllimport) void* __stdcall CreateFileA(const char* name,
+    unsigned long access, unsigned long share, void* security,
+    unsigned long disposition, unsigned long flags, void* tmpl);
+extern "C" __declspec(dllimport) int __stdcall GetFileSizeEx(void* file,
+    long long* size);
+extern "C" __declspec(dllimport) void* __stdcall CreateFileMappingA(void* file,
+    void* security, unsigned long protect, unsigned long sizeHi,
+    unsigned long sizeLo, const char* name);
+extern "C" __declspec(dllimport) void* __stdcall MapViewOfFile(void* mapping,
+    unsigned long access, unsigned long offHi, unsigned long offLo, size_t bytes);
+extern "C" __declspec(dllimport) int __stdcall UnmapViewOfFile(const void* base);
+extern "C" __declspec(dllimport) int __stdcall CloseHandle(void* handle);
+#endif
+
+// A whole file mapped read-only
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const char* path)
+    {
+        close();
+#if defined(_WIN32)
+        void* const invalid = (void*)(intptr_t)-1;
+        file = CreateFileA(path, 0x80000000ul /* GENERIC_READ */,
+            1 /* FILE_SHARE_READ */, nullptr, 3 /* OPEN_EXISTING */,
+            0x80 /* FILE_ATTRIBUTE_NORMAL */, nullptr);
+        if (file == invalid) { file = nullptr; return false; }
+        long long sz = 0;
+        if (!GetFileSizeEx(file, &sz) || sz <= 0) { close(); return false; }
+        mapping = CreateFileMappingA(file, nullptr, 2 /* PAGE_READONLY */,
+            0, 0, nullptr);
+        if (!mapping) { close(); return false; }
+        base = (const unsigned char*)MapViewOfFile(mapping, 4 /* FILE_MAP_READ */,
+            0, 0, 0);
+        len = (size_t)sz;
+#else
+        fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) { close(); return false; }
+        len = (size_t)st.st_size;
+        void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        base = p == MAP_FAILED ? nullptr : (const unsigned char*)p;
+        if (base) madvise(p, len, MADV_SEQUENTIAL);
+#endif
+        if (!base) { close(); return false; }
+        return true;
+    }
 
-    switch (s.algo) {
-    case BUBBLE:    buildBubble(s);    break;
-    case SELECTION: buildSelection(s); break;
-    case INSERTION: buildInsertion(s); break;
-    case MERGE:     buildMerge(s);     break;
-    case QUICK:     buildQuick(s);     break;
-    case HEAP:      buildHeap(s);      break;
-    default: break;
+    void close()
+    {
+#if defined(_WIN32)
+        if (base) UnmapViewOfFile(base);
+        if (mapping) CloseHandle(mapping);
+        if (file) CloseHandle(file);
+        mapping = file = nullptr;
+#else
+        if (base) munmap((void*)base, len);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        base = nullptr;
+        len = 0;
     }
-}
 
-//  Drawing helpers
+    const unsigned char* data() const { return base; }
+    size_t               size() const { return len; }
+
+private:
+#if defined(_WIN32)
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int   fd = -1;
+#endif
+    const unsigned char* base = nullptr;
+    size_t               len = 0;
+};
 
-// Gradient bar with an optional vertical scale (for wave animation)
-static void drawGradBar(int x, int y, int w, int h,
-    Color lo, Color hi, float scale = 1.f)
-{
-    if (h <= 0) return;
+// Read side of a trace file
+class TraceFile {
+public:
+    bool open(const char* path)
+    {
+        if (!map.open(path)) return false;
+        const unsigned char* p = map.data();
+        size_t sz = map.size();
+        if (sz < sizeof(TraceHeader)) return fail();
+        std::memcpy(&hdr, p, sizeof(hdr));
+        if (std::memcmp(hdr.magic, "STRC", 4) || hdr.version != TRACE_VERSION
+            || hdr.algo >= ALGO_COUNT || hdr.pattern >= PAT_COUNT
+            || hdr.pivot >= PIVOT_COUNT || hdr.partition >= PART_COUNT
+            || hdr.extRunSize < 0 || hdr.extFanIn < 2
+            || hdr.extFanIn > EXT_FANIN_MAX || hdr.extRunQuick > 1
+            || hdr.n > (uint32_t)INT_MAX / 4 || hdr.every == 0
+            || hdr.keys != (hdr.events + hdr.every - 1) / hdr.every
+            || sizeof(hdr) + (uint64_t)hdr.n * 4 > hdr.indexOffset
+            || hdr.indexOffset > sz
+            || hdr.keys > (sz - hdr.indexOffset) / sizeof(TraceKey)
+            || hdr.indexOffset + hdr.keys * sizeof(TraceKey) != sz)
+            return fail();
+
+        // Every keyframe block lies between the previous one's events and
+        // the index, and its run list ends where its events start
+        uint64_t at = sizeof(hdr) + (uint64_t)hdr.n * 4;
+        uint64_t fixed = blockBytes(0);
+        for (uint64_t j = 0; j < hdr.keys; j++) {
+            TraceKey k = key((long long)j);
+            if (k.keyOffset < at || k.keyOffset > hdr.indexOffset
+                || hdr.indexOffset - k.keyOffset < fixed)
+                return fail();
+            uint32_t runs;
+            std::memcpy(&runs, p + k.keyOffset + fixed - 4, 4);
+            if (runs > hdr.n || k.streamOffset != k.keyOffset + blockBytes(runs)
+                || k.streamOffset > hdr.indexOffset)
+                return fail();
+            at = k.streamOffset;
+        }
 
-    int dh = (int)(h * scale);   // scaled height
-    int dy = y + (h - dh);       // anchor to bottom
+        // A damaged file still replays up to its damage (see cutTrace), so
+        // the start has to decode
+        if (hdr.keys) {
+            Keyframe k;
+            TraceCursor c;
+            Op op{};
+            if (!keyframe(0, k) || !next(c, op)) return fail();
+        }
+        return true;
+    }
 
-    DrawRectangleGradientV(x, dy, w, dh, hi, lo);
+    const TraceHeader& header() const { return hdr; }
+    long long events() const { return (long long)hdr.events; }
+    long long keys() const { return (long long)hdr.keys; }
+    int       every() const { return (int)hdr.every; }
 
-    int capH = std::min(dh, 5);
-    DrawRectangleRounded(
-        { (float)x, (float)dy, (float)w, (float)capH },
-        0.5f, 4, hi
-    );
-}
+    void initial(std::vector<int>& v) const
+    {
+        v.resize(hdr.n);
+        if (hdr.n) std::memcpy(v.data(), map.data() + sizeof(hdr), hdr.n * 4);
+    }
 
-// Soft ambient halo behind an active bar
-static void drawGlow(int x, int y, int w, int h, Color c)
-{
-    DrawRectangle(x - 2, y - 3, w + 4, h + 3,
-        { c.r, c.g, c.b, 35 });
-}
+    // Position c just after keyframe j
+    void seekKey(TraceCursor& c, long long j) const
+    {
+        TraceKey k = key(j);
+        c.off = k.streamOffset;
+        c.event = j * hdr.every;
+        c.prevA = k.prevA;
+        c.prevB = k.prevB;
+        c.nextKey = j + 1;
+    }
 
-// Stat card with a coloured accent stripe at the top
-static void drawCard(int x, int y, int w, int h,
-    const char* label, const char* val,
-    Color accent)
-{
-    DrawRectangleRounded(
-        { (float)x, (float)y, (float)w, (float)h },
-        0.18f, 8, C_CARD
-    );
-    DrawRectangleRounded(
-        { (float)x, (float)y, (float)w, 3.f },
-        0.3f, 4, accent
-    );
-    DrawText(label, x + 12, y + 9, 13, C_SUBTEXT);
-    DrawText(val, x + 12, y + 28, 20, C_TEXT);
-}
+    // False at the end, or where the stream fails to decode
+    bool next(TraceCursor& c, Op& op) const
+    {
+        if (c.event >= events()) return false;
+        if (c.nextKey < hdr.keys && c.event == (long long)(c.nextKey * hdr.every))
+            c.off = key(c.nextKey++).streamOffset;   // step over the block
+
+        // This stretch of events ends at the next block
+        uint64_t stop = c.nextKey < hdr.keys ? key(c.nextKey).keyOffset
+                                              : hdr.indexOffset;
+        const unsigned char* p = map.data() + c.off;
+        const unsigned char* end = map.data() + stop;
+        uint64_t da, db;
+        if (p >= end) return false;
+        unsigned char tag = *p++;
+        if (!varint(p, end, da) || !varint(p, end, db)) return false;
+        OpKind kind = (OpKind)(tag & 15);
+        int    lane = tag >> 4;
+        long long a = c.prevA + unzig(da);
+        long long b = (pairOp(kind) ? a : c.prevB) + unzig(db);
+        if (kind > OP_MARK_MERGE || lane > MAX_LANES || !opInRange(kind, a, b))
+            return false;
+
+        op.kind = kind;
+        op.lane = (unsigned char)lane;
+        op.a = (int)a;
+        op.b = (int)b;
+        c.prevA = op.a;
+        c.prevB = op.b;
+        c.off = (uint64_t)(p - map.data());
+        c.event++;
+        return true;
+    }
 
-// Outlined rounded rectangle (no fill)
-static void drawRoundBorder(float x, float y, float w, float h,
-    float radius, Color c)
-{
-    DrawRectangleRoundedLines({ x, y, w, h }, radius, 8, c);
-}
+    // False if the block holds state no replay could reach
+    bool keyframe(long long j, Keyframe& k) const
+    {
+        const unsigned char* p = map.data() + key(j).keyOffset;
+        auto get = [&p](void* dst, size_t bytes) {
+            std::memcpy(dst, p, bytes);
+            p += bytes;
+        };
+        int n = (int)hdr.n;
+        k.bars.resize(n);
+        get(k.bars.data(), (size_t)n * 4);
+        k.colorMap.resize(n);
+        for (int i = 0; i < n; i++) k.colorMap[i] = *p++;
+        get(k.lit, sizeof(k.lit));
+        get(&k.comparisons, 8);
+        get(&k.swaps, 8);
+        get(&k.progress, 4);
+        get(&k.sortedBelow, 4);
+        get(&k.sortedFrom, 4);
+        int32_t fb;
+        get(&fb, 4);
+        k.fallback = (OpKind)fb;
+        get(&k.fallbackLo, 4);
+        get(&k.fallbackHi, 4);
+        get(&k.insertionRuns, 4);
+        get(&k.heapRuns, 4);
+        uint32_t runs;
+        get(&runs, 4);
+        k.runs.resize(runs);                  // bounded by open()
+        for (auto& r : k.runs) { get(&r.first, 4); get(&r.second, 4); }
+
+        for (int c : k.colorMap)
+            if (c >= 4 + MAX_LANES) return false;
+        for (auto& lit : k.lit)
+            for (int i : lit)
+                if (i < -1 || i >= n) return false;
+        for (auto& r : k.runs)
+            if (r.first < 0 || r.second >= n || r.first > r.second) return false;
+        return k.sortedBelow >= 0 && k.sortedBelow <= n
+            && k.sortedFrom >= 0 && k.sortedFrom <= n
+            && fb >= 0 && fb <= OP_MARK_MERGE
+            && span(k.fallbackLo, k.fallbackHi, n);
+    }
 
-//  Bar area  (animation-aware)
+private:
+    MappedFile  map;
+    TraceHeader hdr = {};
 
-static void drawBars(const SortState& s, const AnimState& anim)
-{
-    int n = s.barCount();
-    int bw = (SW - BAR_GAP * (n + 1)) / n;
+    bool fail() { map.close(); return false; }
 
-    // Subtle grid lines at 25 / 50 / 75 %
-    for (int pct = 25; pct < 100; pct += 25) {
-        int gy = BAR_AREA_Y + (int)(BAR_AREA_H * (1.f - pct / 100.f));
-        DrawLine(0, gy, SW, gy, { 30, 36, 60, 255 });
-        DrawText(TextFormat("%d%%", pct),
-            5, gy - 13, 11, { 46, 54, 86, 255 });
+    TraceKey key(long long j) const
+    {
+        TraceKey k;
+        std::memcpy(&k, map.data() + hdr.indexOffset + j * sizeof(TraceKey),
+            sizeof(k));
+        return k;
     }
 
-    for (int i = 0; i < n; i++) {
-        float t = (float)s.bars[i] / n;
-        int   bh = (int)(t * BAR_AREA_H);
-        int   bx = BAR_GAP + i * (bw + BAR_GAP);
-        int   by = BAR_AREA_Y + (BAR_AREA_H - bh);
-
-        // ── Wave scale: bar rises from 0 → full height on shuffle ──
-        float scale = 1.f;
-        if (anim.shuffleActive && i < (int)anim.waveOffset.size()) {
-            float local = (anim.shuffleTimer - anim.waveOffset[i]) * 3.f;
-            local = std::max(0.f, std::min(1.f, local));
-            // Ease-out cubic
-            float inv = 1.f - local;
-            scale = 1.f - inv * inv * inv;
-        }
+    // Bytes in a keyframe block with `runs` sorted runs
+    uint64_t blockBytes(uint64_t runs) const
+    {
+        uint64_t n = hdr.n;
+        return n * 4 + n + sizeof(Keyframe::lit) + 8 + 8 + 4 * 9 + runs * 8;
+    }
 
-        // ── Fanfare: bright gold flash near the sweep front ─────────
-        Color lo, hi;
-        float fanDist = std::abs((float)i - anim.fanfarePos);
+    // a .. b (inclusive, possibly empty) lies within the bars
+    bool span(long long a, long long b, long long n) const
+    {
+        return a >= 0 && b < n && a <= b + 1;
+    }
 
-        if (anim.fanfareActive && fanDist <= 4.f) {
-            float blend = 1.f - fanDist / 4.f;
-            lo = lerpCol(C_SRT_LO, { 255, 255, 180, 255 }, blend);
-            hi = lerpCol(C_SRT_HI, { 255, 255, 220, 255 }, blend);
+    // The indices op would touch are all bars
+    bool opInRange(OpKind kind, long long a, long long b) const
+    {
+        long long n = hdr.n;
+        switch (kind) {
+        case OP_COMPARE:
+        case OP_SWAP:
+            return a >= 0 && a < n && b >= 0 && b < n;
+        case OP_WRITE:
+            return a >= 0 && a < n && b >= INT_MIN && b <= INT_MAX;
+        case OP_READ:
+            return a >= 0 && a < n;
+        default:
+            return span(a, b, n);
         }
-        else {
-            switch (s.colorMap[i]) {
-            case 1:
-                lo = C_CMP_LO; hi = C_CMP_HI;
-                drawGlow(bx, by, bw, bh, hi);
-                break;
-            case 2:
-                lo = C_SWP_LO; hi = C_SWP_HI;
-                drawGlow(bx, by, bw, bh, hi);
-                break;
-            case 3:
-                lo = C_SRT_LO; hi = C_SRT_HI;
-                break;
-            default:
-                lo = C_BAR_LO; hi = C_BAR_HI;
-                break;
-            }
+    }
+
+    static bool varint(const unsigned char*& p, const unsigned char* end, uint64_t& v)
+    {
+        v = 0;
+        for (int sh = 0; sh < 64 && p < end; sh += 7) {
+            unsigned char b = *p++;
+            v |= (uint64_t)(b & 127) << sh;
+            if (!(b & 128)) return true;
         }
+        return false;
+    }
+    static long long unzig(uint64_t z) { return (long long)(z >> 1) ^ -(long long)(z & 1); }
+};
+
+// Write side: events in replay order, with the replay state in front of
+// every K-th one
+class TraceWriter {
+public:
+    ~TraceWriter() { if (f) std::fclose(f); }
 
-        drawGradBar(bx, by, bw, bh, lo, hi, scale);
+    bool open(const char* path, const TraceHeader& h, const std::vector<int>& bars)
+    {
+        f = std::fopen(path, "wb");
+        if (!f) return false;
+        hdr = h;
+        put(&hdr, sizeof(hdr));                // patched by finish()
+        put(bars.data(), bars.size() * 4);
+        return true;
     }
-}
 
-//  UI panels  (each row is its own function)
+    // True when the next event needs the replay state written first
+    bool wantsKeyframe() const { return events % hdr.every == 0; }
 
-static void drawHeader(const SortState& s)
-{
+    void keyframe(const Keyframe& k)
+    {
+        TraceKey e = { pos, 0, prevA, prevB };
+        put(k.bars.data(), k.bars.size() * 4);
+        for (int c : k.colorMap) buf.push_back((unsigned char)c);
+        pos += k.colorMap.size();
+        put(k.lit, sizeof(k.lit));
+        put(&k.comparisons, 8);
+        put(&k.swaps, 8);
+        put(&k.progress, 4);
+        put(&k.sortedBelow, 4);
+        put(&k.sortedFrom, 4);
+        int32_t fb = k.fallback;
+        put(&fb, 4);
+        put(&k.fallbackLo, 4);
+        put(&k.fallbackHi, 4);
+        put(&k.insertionRuns, 4);
+        put(&k.heapRuns, 4);
+        uint32_t runs = (uint32_t)k.runs.size();
+        put(&runs, 4);
+        for (auto& r : k.runs) { put(&r.first, 4); put(&r.second, 4); }
+        e.streamOffset = pos;
+        index.push_back(e);
+    }
+
+    void event(const Op& op)
+    {
+        buf.push_back((unsigned char)(op.kind | op.lane << 4));
+        pos++;
+        varint(zig((long long)op.a - prevA));
+        varint(zig((long long)op.b - (pairOp(op.kind) ? op.a : prevB)));
+        prevA = op.a;
+        prevB = op.b;
+        events++;
+        if (buf.size() >= (1 << 20)) flush();
+    }
+
+    long long count() const { return events; }
+    uint64_t  bytes() const { return pos; }
+
+    bool finish()
+    {
+        hdr.events = (uint64_t)events;
+        hdr.keys = index.size();
+        hdr.indexOffset = pos;
+        put(index.data(), index.size() * sizeof(TraceKey));
+        flush();
+        bool ok = !std::ferror(f) && std::fseek(f, 0, SEEK_SET) == 0
+            && std::fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+        ok = std::fclose(f) == 0 && ok;
+        f = nullptr;
+        return ok;
+    }
+
+private:
+    std::FILE*  f = nullptr;
+    TraceHeader hdr = {};
+    std::vector<TraceKey>      index;
+    std::vector<unsigned char> buf;
+    uint64_t    pos = 0;              // file offset of the next byte
+    long long   events = 0;
+    int         prevA = 0, prevB = 0;
+
+    void put(const void* p, size_t bytes)
+    {
+        auto* b = (const unsigned char*)p;
+        buf.insert(buf.end(), b, b + bytes);
+        pos += bytes;
+    }
+
+    void varint(uint64_t v)
+    {
+        for (; v >= 128; v >>= 7) { buf.push_back((unsigned char)(v | 128)); pos++; }
+        buf.push_back((unsigned char)v);
+        pos++;
+    }
+    static uint64_t zig(long long d) { return ((uint64_t)d << 1) ^ (uint64_t)(d >> 63); }
+
+    void flush()
+    {
+        if (!buf.empty()) std::fwrite(buf.data(), 1, buf.size(), f);
+        buf.clear();
+    }
+};
+
+// What the window has replayed, or for a loaded trace file everything
+// it can replay
+struct History {
+    bool on = false;              // the window's run records; race lanes don't
+    bool overflow = false;        // grew past HIST_MAX_EVENTS, dropped
+    bool complete = false;        // the run's end has been replayed
+    int  every = HIST_KEY_MIN;    // K: keys[j] is the state before event j·K
+    float liveProgress = 0.f;     // engine progress at the newest event
+    std::vector<Delta>    deltas;
+    std::vector<Keyframe> keys;
+
+    // Replaying a trace file instead: the whole run is on disk
+    const TraceFile* file = nullptr;
+    TraceCursor      cur;         // at the replay's stepIdx
+    Keyframe         scratch;     // the file keyframe being restored
+    long long        cut = -1;    // the file fails to decode from here on
+
+    long long size() const
+    {
+        if (!file) return (long long)deltas.size();
+        return cut >= 0 ? cut : file->events();
+    }
+    size_t    keyCount() const { return file ? (size_t)file->keys() : keys.size(); }
+    bool      usable() const
+    {
+        return on && (file ? size() > 0 : !overflow && !deltas.empty());
+    }
+
+    void clear()
+    {
+        overflow = false;
+        complete = file != nullptr;
+        liveProgress = file ? 1.f : 0.f;
+        if (file) every = file->every();
+        cur = {};
+        deltas.clear(); deltas.shrink_to_fit();
+        keys.clear();
+    }
+};
+
+//  Sort state
+
+// A run's final counters, from a dry run (see tallyRun)
+struct Tally {
+    bool      valid = false;      // false: skipped or gave up
+    long long events = 0;
+    long long comparisons = 0;
+    long long swaps = 0;          // swaps and writes, as on the cards
+    double    ms = 0.0;
+};
+
+struct SortState {
+    std::vector<int> bars;
+    std::vector<int> initial;    // bars as last shuffled (native runs)
+    std::vector<int> colorMap;   // 0 default · 1 compare · 2 swap · 3 sorted
+                                 // 3 + lane for parallel workers
+
+    Algorithm  algo = BUBBLE;
+    EngineOptions opts;
+    InputSpec  input;
+    bool       running = false;
+    bool       finished = false;
+    int        speed = 5;     // 1 (slow) … 10 (max), see SPEED_RATE
+    int        sizeIdx = 3;     // index into SIZE_OPTIONS  (default 100)
+    int        groupIdx = 0;    // index into GROUP_OPTIONS (default 1)
+    long long  comparisons = 0;
+    long long  swaps = 0;
+
+    RunArena  arena;                  // bench only: backs `engine`
+    std::unique_ptr<Engine> engine;   // bench only; the window uses SortWorker
+    long long stepIdx = 0;            // events replayed so far
+    float     progress = 0.f;         // engine's work estimate, 0 → 1
+
+    bool      started = false;        // a run has been handed to the worker
+    unsigned  epoch = 0;              // SortWorker epoch of the live run
+
+    // Bars highlighted by the last event of each lane (0 = sequential)
+    int lit[MAX_LANES + 1][2];
+
+    double speedup = 0.0;        // parallel engines: 1-worker / N-worker time
+    int    workers = 0;
+
+    MemProbe mem;
+    History  hist;               // window only: what the scrubber can seek
+    Tally    total;              // window only: the whole run, if known
+    double   etaSec = -1.0;      // replay left at this speed (-1 unknown)
+
+    // Taken from the system by this run's arena
+    size_t    arenaBytes = 0;
+    long long arenaAllocs = 0;
+
+    // Intro Sort: the latest fallback range, and how often each fired.
+    // External Sort: the merge in progress (fallback = OP_MARK_MERGE)
+    OpKind fallback = OP_SORTED;      // OP_MARK_* once one has fired
+    int    fallbackLo = 0;
+    int    fallbackHi = -1;
+    int    insertionRuns = 0;
+    int    heapRuns = 0;
+
+    // TimSort: the runs on its stack, inclusive [first, second], in order
+    std::vector<std::pair<int, int>> runs;
+
+    // Bitonic Sort on the GPU (B): whether there is one, whether the run
+    // goes to it, and the passes dispatched so far (see GpuBitonic)
+    bool gpuReady = false;
+    bool onGpu = false;
+    int  gpuPass = 0;
+    int  gpuPasses = 0;
+
+    // Sorted regions are kept as a prefix / suffix boundary; only
+    // scattered finals (Quick Sort pivots) are written into colorMap
+    int sortedBelow = 0;         // [0, sortedBelow) is final
+    int sortedFrom = 0;          // [sortedFrom, n) is final
+
+    // Bars changed since the renderer last looked (lo > hi = none)
+    int dirtyLo = INT_MAX;
+    int dirtyHi = -1;
+
+    // Column view only: which BLOCK-sized runs of values changed, so the
+    // renderer's min/max pyramid can be patched instead of rebuilt
+    std::vector<unsigned char> blockDirty;
+    std::vector<int>           dirtyBlocks;
+    unsigned                   generation = 0;   // bumped when bars refill
+
+    int barCount() const { return (int)bars.size(); }
+    int group() const { return GROUP_OPTIONS[groupIdx]; }
+
+    SortState() { for (auto& l : lit) l[0] = l[1] = -1; }
+};
+
+//  Utility helpers
+
+// Widen the renderer's dirty range to cover [lo, hi]
+static void touch(SortState& s, int lo, int hi)
+{
+    s.dirtyLo = std::min(s.dirtyLo, lo);
+    s.dirtyHi = std::max(s.dirtyHi, hi);
+}
+
+// Values in bar i changed
+static void touchValue(SortState& s, int i)
+{
+    touch(s, i, i);
+    if (!s.blockDirty.empty()) {
+        int b = i >> BLOCK_SHIFT;
+        if (!s.blockDirty[b]) {
+            s.blockDirty[b] = 1;
+            s.dirtyBlocks.push_back(b);
+        }
+    }
+}
+
+static void enableBlockTracking(SortState& s)
+{
+    s.blockDirty.assign((s.barCount() >> BLOCK_SHIFT) + 1, 0);
+    s.dirtyBlocks.clear();
+}
+
+// Forget all colouring and mark every bar for repaint
+static void clearColors(SortState& s)
+{
+    std::fill(s.colorMap.begin(), s.colorMap.end(), 0);
+    for (auto& l : s.lit) l[0] = l[1] = -1;
+    s.sortedBelow = 0;
+    s.sortedFrom = s.barCount();
+    touch(s, 0, s.barCount() - 1);
+}
+
+// Clear the compare / swap highlights of a lane's previous event; sorted
+// bars stay green.  Only the bars that event lit are touched, so this is
+// O(1).  Worker lanes keep their own highlights so every thread shows.
+static void resetColors(SortState& s, int lane)
+{
+    for (int& i : s.lit[lane]) {
+        if (i >= 0) {
+            if (s.colorMap[i] != 3) s.colorMap[i] = 0;
+            touch(s, i, i);
+        }
+        i = -1;
+    }
+}
+
+static void resetAllColors(SortState& s)
+{
+    for (int lane = 0; lane <= MAX_LANES; lane++) resetColors(s, lane);
+}
+
+// Record [a, b] as final.  Ranges that extend the sorted prefix or suffix
+// just move a boundary; anything else is painted into colorMap.
+static void markSorted(SortState& s, int a, int b)
+{
+    int n = s.barCount();
+
+    if (a <= s.sortedBelow && b >= s.sortedBelow) {
+        s.sortedBelow = b + 1;
+        while (s.sortedBelow < n && s.colorMap[s.sortedBelow] == 3)
+            s.sortedBelow++;
+    }
+    else if (b >= s.sortedFrom - 1 && a < s.sortedFrom) {
+        s.sortedFrom = a;
+        while (s.sortedFrom > 0 && s.colorMap[s.sortedFrom - 1] == 3)
+            s.sortedFrom--;
+    }
+    else {
+        std::fill(s.colorMap.begin() + a, s.colorMap.begin() + b + 1, 3);
+    }
+    touch(s, a, b);
+}
+
+// Effective colour state of bar i (see colorMap; 4+ = worker lane)
+static int barState(const SortState& s, int i)
+{
+    int c = s.colorMap[i];
+    if (c == 0 && (i < s.sortedBelow || i >= s.sortedFrom)) return 3;
+    return c;
+}
+
+// Compact count: 950, 12.3k, 4.56M, 1.20G
+static void fmtSI(char* out, size_t cap, double v)
+{
+    if (v < 1e3)      snprintf(out, cap, "%.0f", v);
+    else if (v < 1e6) snprintf(out, cap, "%.1fk", v / 1e3);
+    else if (v < 1e9) snprintf(out, cap, "%.2fM", v / 1e6);
+    else              snprintf(out, cap, "%.2fG", v / 1e9);
+}
+
+// Seconds as "4.2 s", "3:07" or "1h 05m"
+static void fmtDuration(char* out, size_t cap, double sec)
+{
+    long long m = (long long)(sec / 60);
+    if (sec < 60)        snprintf(out, cap, "%.1f s", sec);
+    else if (m < 60)     snprintf(out, cap, "%lld:%02d", m, (int)sec % 60);
+    else                 snprintf(out, cap, "%lldh %02lldm", m / 60, m % 60);
+}
+
+// Linear colour interpolation
+static Color lerpCol(Color a, Color b, float t)
+{
+    return {
+        (unsigned char)(a.r + (b.r - a.r) * t),
+        (unsigned char)(a.g + (b.g - a.g) * t),
+        (unsigned char)(a.b + (b.b - a.b) * t),
+        255
+    };
+}
+
+// Zero the counters and colouring for a fresh run
+static void resetRun(SortState& s)
+{
+    s.stepIdx = 0;
+    s.comparisons = 0;
+    s.swaps = 0;
+    s.progress = 0.f;
+    s.speedup = 0.0;
+    s.workers = 0;
+    s.fallback = OP_SORTED;
+    s.fallbackLo = 0;
+    s.fallbackHi = -1;
+    s.insertionRuns = 0;
+    s.heapRuns = 0;
+    s.runs.clear();
+    s.gpuPass = 0;
+    s.gpuPasses = 0;
+    s.arenaBytes = 0;
+    s.arenaAllocs = 0;
+    s.total = {};
+    s.etaSec = -1.0;
+    s.mem.reset();
+    s.hist.clear();
+    clearColors(s);
+}
+
+//  Input patterns
+//
+//  Every pattern yields values in 1..n so bar heights stay comparable.
+//  Only mt19937's raw output is used: the std distributions and
+//  std::shuffle differ between standard libraries, which would make a
+//  seed mean different arrays on different machines.
+
+// Uniform integer in [0, m)
+static int randBelow(std::mt19937& rng, int m)
+{
+    return (int)(((uint64_t)rng() * (uint64_t)m) >> 32);
+}
+
+static void fisherYates(std::vector<int>& v, std::mt19937& rng)
+{
+    for (int i = (int)v.size() - 1; i > 0; i--)
+        std::swap(v[i], v[randBelow(rng, i + 1)]);
+}
+
+static void makeInput(std::vector<int>& v, int n, const InputSpec& in)
+{
+    std::mt19937 rng(in.seed);
+    v.resize(n);
+    if (n == 0) return;
+
+    switch (in.pattern) {
+    case PAT_UNIFORM:
+        std::iota(v.begin(), v.end(), 1);
+        fisherYates(v, rng);
+        break;
+    case PAT_SORTED:
+        std::iota(v.begin(), v.end(), 1);
+        break;
+    case PAT_REVERSE:
+        for (int i = 0; i < n; i++) v[i] = n - i;
+        break;
+    case PAT_NEARLY: {
+        std::iota(v.begin(), v.end(), 1);
+        int k = in.swaps >= 0 ? in.swaps : std::max(1, n / 100);
+        for (int i = 0; i < k; i++)
+            std::swap(v[randBelow(rng, n)], v[randBelow(rng, n)]);
+        break;
+    }
+    case PAT_FEW_UNIQUE: {
+        int keys = std::min(n, FEW_UNIQUE_KEYS);
+        for (int i = 0; i < n; i++)
+            v[i] = (int)((long long)(randBelow(rng, keys) + 1) * n / keys);
+        break;
+    }
+    case PAT_ORGAN_PIPE:
+        // odd values climbing to n, even values falling back down
+        for (int i = 0; i < n; i++)
+            v[i] = i < (n + 1) / 2 ? 2 * i + 1 : 2 * (n - i);
+        break;
+    case PAT_SAWTOOTH: {
+        int tooth = std::max(1, (n + SAW_TEETH - 1) / SAW_TEETH);
+        for (int i = 0; i < n; i++)
+            v[i] = (int)((long long)(i % tooth + 1) * n / tooth);
+        break;
+    }
+    case PAT_ZIPF: {
+        // Rank r is drawn with weight 1 / r^s; ranks map to evenly spaced
+        // values in a shuffled order, so the common keys aren't all small
+        int keys = std::max(2, std::min(n / 8, 4096));
+        std::vector<double> cdf(keys);
+        double sum = 0.0;
+        for (int r = 0; r < keys; r++)
+            cdf[r] = sum += 1.0 / std::pow(r + 1.0, ZIPF_S);
+
+        std::vector<int> value(keys);
+        for (int r = 0; r < keys; r++)
+            value[r] = (int)((long long)(r + 1) * n / keys);
+        fisherYates(value, rng);
+
+        for (int i = 0; i < n; i++) {
+            double u = (rng() + 0.5) / 4294967296.0 * sum;
+            int r = (int)(std::lower_bound(cdf.begin(), cdf.end(), u)
+                - cdf.begin());
+            v[i] = value[std::min(r, keys - 1)];
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// Fill bars from s.input (or the loaded trace file) and clear all run state
+static void fillBars(SortState& s, int n)
+{
+    s.colorMap.assign(n, 0);
+
+    if (s.hist.file) s.hist.file->initial(s.bars);
+    else makeInput(s.bars, n, s.input);
+    s.initial = s.bars;
+    s.blockDirty.clear();
+    s.dirtyBlocks.clear();
+    s.generation++;
+
+    s.running = false;
+    s.finished = false;
+    s.engine.reset();
+    s.started = s.hist.file != nullptr;   // a recording needs no engine
+    resetRun(s);
+}
+
+// Shuffle bars and kick off the wave pop-in animation
+static void shuffle(SortState& s, AnimState& anim)
+{
+    int n = s.hist.file ? (int)s.hist.file->header().n : SIZE_OPTIONS[s.sizeIdx];
+    fillBars(s, n);
+
+    // Large arrays are drawn per column; let the renderer see which
+    // blocks of values change
+    if (columnMode(n)) enableBlockTracking(s);
+
+    // Stagger each bar's pop-in by its normalised position
+    anim.shuffleActive = true;
+    anim.shuffleTimer = 0.f;
+
+    anim.fanfareActive = false;
+}
+
+// Replay a recorded trace file: its algorithm, options and input become
+// the current ones until something changes them (see fillBars)
+static void attachTrace(SortState& s, const TraceFile* f)
+{
+    const TraceHeader& h = f->header();
+    s.algo = (Algorithm)h.algo;
+    s.opts.heapArity = h.heapArity;
+    s.opts.pivot = (PivotRule)h.pivot;
+    s.opts.partition = (PartitionScheme)h.partition;
+    s.opts.introCutoff = h.introCutoff;
+    s.opts.introDepth = h.introDepth;
+    s.opts.extRunSize = h.extRunSize;
+    s.opts.extFanIn = h.extFanIn;
+    s.opts.extRunQuick = h.extRunQuick != 0;
+    s.input.pattern = (InputPattern)h.pattern;
+    s.input.seed = h.seed;
+    s.input.swaps = h.swaps;
+    s.hist.file = f;
+    s.hist.cut = -1;
+}
+
+// Advance the shuffle wave and the completion sweep of n bars by dt
+static void tickAnim(AnimState& anim, int n, float dt)
+{
+    if (anim.shuffleActive) {
+        anim.shuffleTimer += dt * 1.4f;   // full wave in ~0.7 s
+        if (anim.shuffleTimer >= 1.f)
+            anim.shuffleActive = false;
+    }
+
+    if (anim.fanfareActive) {
+        anim.fanfarePos += dt * n * 2.5f;
+        if (anim.fanfarePos > n + 6)
+            anim.fanfareActive = false;
+    }
+}
+
+// The replay reached its end: everything is final, start the sweep
+static void finishRun(SortState& s, AnimState& anim)
+{
+    s.running = false;
+    s.finished = true;
+    resetAllColors(s);
+    markSorted(s, 0, s.barCount() - 1);
+
+    anim.fanfareActive = true;
+    anim.fanfarePos = 0.f;
+}
+
+//  Replay pacing
+//
+//  Speed is a rate in steps per second, and every engine emits one event
+//  per compare, swap, write or read, so a level means the same amount of
+//  work whatever the algorithm.  A step is one event, or a group of them
+//  (GROUP_OPTIONS) to cover large inputs at a watchable rate.  Each frame
+//  the pacer grants the whole steps owed since the last one (fractions
+//  carry over) and a time budget: the
+//  frame period less what drawing has recently cost.  The top level has
+//  no rate and replays as much as that budget holds, so even "max" keeps
+//  the target frame rate.
+
+static const int    SPEED_LEVELS = 10;
+static const double SPEED_RATE[SPEED_LEVELS] = {     // steps / s, 0 = max
+    5, 15, 40, 100, 250, 1000, 5000, 30000, 200000, 0
+};
+
+static bool speedIsMax(int speed) { return SPEED_RATE[speed - 1] == 0; }
+
+// Events per second: "250/s", "30.0k/s", "max"
+static void fmtSpeed(char* out, size_t cap, int speed, int group)
+{
+    if (speedIsMax(speed)) { snprintf(out, cap, "max"); return; }
+    char v[16];
+    fmtSI(v, sizeof(v), SPEED_RATE[speed - 1] * group);
+    snprintf(out, cap, "%s/s", v);
+}
+
+struct Pacer {
+    double owed = 0.0;            // granted, not yet replayed
+    double drawSec = 0.004;       // smoothed CPU cost of drawing a frame
+    double seen = 0.0;            // smoothed events / s actually replayed
+
+    // Events to replay this frame, dt seconds after the last: whole
+    // steps of `group` events
+    long long grant(int speed, int group, float dt)
+    {
+        if (speedIsMax(speed)) return LLONG_MAX;
+        double rate = SPEED_RATE[speed - 1] * group;
+        owed = std::min(owed + rate * dt, group + rate / 4);   // bank ≤ 1/4 s
+        return (long long)(owed / group) * group;
+    }
+
+    void used(long long events)
+    {
+        owed = std::max(0.0, owed - (double)events);
+    }
+
+    // Seconds replay may take this frame
+    double budget() const
+    {
+        return std::max(0.001, std::min(0.012,
+            1.0 / TARGET_FPS - drawSec - 0.002));
+    }
+
+    void noteDraw(double sec) { drawSec += 0.1 * (sec - drawSec); }
+
+    void noteRate(long long events, float dt)
+    {
+        if (dt > 0.f) seen += 0.05 * (events / dt - seen);
+    }
+
+    // Seconds to replay `left` more events at this speed (-1 unknown)
+    double eta(int speed, int group, long long left) const
+    {
+        double rate = speedIsMax(speed) ? seen : SPEED_RATE[speed - 1] * group;
+        return rate > 0.0 ? left / rate : -1.0;
+    }
+};
+
+// The parallel engines record their whole trace before replay, 16 bytes
+// an event.  They are refused past PARALLEL_TRACE_MAX elements (about
+// 35 events each there, so ~100 MB) and on an O(n²) input above
+// QUAD_LIMIT, which would blow up to billions of events.
+static const int PARALLEL_TRACE_MAX = 200000;
+
+static bool traceTooLarge(const SortState& s)
+{
+    if (!isParallel(s.algo)) return false;
+    int n = s.barCount();
+    return n > PARALLEL_TRACE_MAX
+        || (n > QUAD_LIMIT && degradesOn(s.algo, s.opts, s.input.pattern));
+}
+
+// What the header and race badge call a refused run
+static const char* refusedLabel(const SortState& s)
+{
+    return s.barCount() > PARALLEL_TRACE_MAX ? "TRACE TOO LARGE" : "O(n²) INPUT";
+}
+
+// Account one event's array traffic (see MemProbe)
+static void probeOp(MemProbe& m, const Op& op)
+{
+    auto ref = [&m](long long line) {
+        m.lineRefs++;
+        if (!m.l1.touch(line)) m.misses++;
+    };
+    long long la = op.a / LINE_ELEMS;
+    long long lb = op.b / LINE_ELEMS;
+
+    switch (op.kind) {
+    case OP_COMPARE:
+    case OP_SWAP:
+        m.reads += 2;
+        if (op.kind == OP_SWAP) m.writes += 2;
+        ref(la);
+        if (lb != la) ref(lb);
+        break;
+    case OP_WRITE:
+        m.writes++;
+        ref(la);
+        break;
+    case OP_READ:
+        m.reads++;
+        ref(la);
+        break;
+    case OP_LOAD:
+        m.reads += op.b - op.a + 1;
+        for (long long l = la; l <= lb; l++) ref(l);
+        break;
+    case OP_SORTED:
+    case OP_MARK_INSERTION:
+    case OP_MARK_HEAP:
+    case OP_MARK_RUN:
+    case OP_MARK_MERGE:
+        return;
+    }
+    m.ops++;
+}
+
+// Highlight the bars op touches in its lane's colours
+static void lightOp(SortState& s, const Op& op)
+{
+    int* lit = s.lit[op.lane];
+    int  cmp = op.lane ? 3 + op.lane : 1;
+    int  swp = op.lane ? 3 + op.lane : 2;
+
+    switch (op.kind) {
+    case OP_COMPARE:
+        if (s.colorMap[op.a] != 3) s.colorMap[op.a] = cmp;
+        if (s.colorMap[op.b] != 3) s.colorMap[op.b] = cmp;
+        lit[0] = op.a; lit[1] = op.b;
+        touch(s, std::min(op.a, op.b), std::max(op.a, op.b));
+        break;
+    case OP_SWAP:
+        s.colorMap[op.a] = swp;
+        s.colorMap[op.b] = swp;
+        lit[0] = op.a; lit[1] = op.b;
+        touch(s, std::min(op.a, op.b), std::max(op.a, op.b));
+        break;
+    case OP_WRITE:
+        s.colorMap[op.a] = swp;
+        lit[0] = op.a;
+        touch(s, op.a, op.a);
+        break;
+    case OP_READ:
+        if (s.colorMap[op.a] != 3) s.colorMap[op.a] = cmp;
+        lit[0] = op.a;
+        touch(s, op.a, op.a);
+        break;
+    default:
+        break;
+    }
+}
+
+// Replay a single trace event.  Writes count as moves on the Swaps card.
+// Events from a worker lane are painted in that lane's colour instead of
+// the compare / swap colours.
+static void applyOp(SortState& s, const Op& op)
+{
+    resetColors(s, op.lane);
+    lightOp(s, op);
+
+    switch (op.kind) {
+    case OP_COMPARE:
+        s.comparisons++;
+        break;
+    case OP_SWAP:
+        std::swap(s.bars[op.a], s.bars[op.b]);
+        touchValue(s, op.a);
+        touchValue(s, op.b);
+        s.swaps++;
+        break;
+    case OP_WRITE:
+        s.bars[op.a] = op.b;
+        touchValue(s, op.a);
+        s.swaps++;
+        break;
+    case OP_SORTED:
+        markSorted(s, op.a, op.b);
+        break;
+    case OP_READ:
+    case OP_LOAD:
+        break;
+    case OP_MARK_INSERTION:
+    case OP_MARK_HEAP:
+        s.fallback = op.kind;
+        s.fallbackLo = op.a;
+        s.fallbackHi = op.b;
+        (op.kind == OP_MARK_HEAP ? s.heapRuns : s.insertionRuns)++;
+        break;
+    case OP_MARK_RUN: {
+        // A merged run replaces the runs it covers
+        auto& rs = s.runs;
+        auto first = std::lower_bound(rs.begin(), rs.end(), op.a,
+            [](const std::pair<int, int>& r, int v) { return r.first < v; });
+        auto last = first;
+        while (last != rs.end() && last->second <= op.b) ++last;
+        rs.insert(rs.erase(first, last), { op.a, op.b });
+        break;
+    }
+    case OP_MARK_MERGE:
+        s.fallback = op.kind;
+        s.fallbackLo = op.a;
+        s.fallbackHi = op.b;
+        break;
+    }
+    if (s.mem.on) probeOp(s.mem, op);
+}
+
+// ── Replay history ────────
+
+static void snapshot(const SortState& s, Keyframe& k)
+{
+    k.bars = s.bars;
+    k.colorMap = s.colorMap;
+    std::memcpy(k.lit, s.lit, sizeof(k.lit));
+    k.comparisons = s.comparisons;
+    k.swaps = s.swaps;
+    k.progress = s.progress;
+    k.sortedBelow = s.sortedBelow;
+    k.sortedFrom = s.sortedFrom;
+    k.fallback = s.fallback;
+    k.fallbackLo = s.fallbackLo;
+    k.fallbackHi = s.fallbackHi;
+    k.insertionRuns = s.insertionRuns;
+    k.heapRuns = s.heapRuns;
+    k.runs = s.runs;
+}
+
+static void takeKeyframe(SortState& s)
+{
+    s.hist.keys.emplace_back();
+    snapshot(s, s.hist.keys.back());
+}
+
+// A trace file is damaged at event t: its replay ends just before it
+static void cutTrace(History& h, long long t)
+{
+    if (h.cut < 0)
+        std::fprintf(stderr, "trace file damaged at event %lld; "
+            "the replay ends there\n", t);
+    h.cut = h.cut < 0 ? t : std::min(h.cut, t);
+}
+
+// Put the replay back to keyframe j, from memory or from the trace file
+static void restoreKeyframe(SortState& s, size_t j)
+{
+    History& h = s.hist;
+    if (h.file) {
+        // open() decoded keyframe 0, so this stops there at the latest
+        while (!h.file->keyframe((long long)j, h.scratch) && j > 0)
+            cutTrace(h, (long long)j-- * h.every);
+        h.file->seekKey(h.cur, (long long)j);
+    }
+    const Keyframe& k = h.file ? h.scratch : h.keys[j];
+    s.bars = k.bars;
+    s.colorMap = k.colorMap;
+    std::memcpy(s.lit, k.lit, sizeof(k.lit));
+    s.comparisons = k.comparisons;
+    s.swaps = k.swaps;
+    s.progress = k.progress;
+    s.sortedBelow = k.sortedBelow;
+    s.sortedFrom = k.sortedFrom;
+    s.fallback = k.fallback;
+    s.fallbackLo = k.fallbackLo;
+    s.fallbackHi = k.fallbackHi;
+    s.insertionRuns = k.insertionRuns;
+    s.heapRuns = k.heapRuns;
+    s.runs = k.runs;
+    s.stepIdx = (long long)j * s.hist.every;
+
+    s.generation++;               // the column view rebuilds its pyramid
+    touch(s, 0, s.barCount() - 1);
+}
+
+// Live replay is about to apply op as event s.stepIdx
+static void recordOp(SortState& s, const Op& op, float progress)
+{
+    History& h = s.hist;
+    if (!h.on || h.overflow) return;
+    if (h.size() >= HIST_MAX_EVENTS) {
+        h.clear();
+        h.overflow = true;
+        return;
+    }
+    if (h.deltas.empty()) h.every = std::max(HIST_KEY_MIN, s.barCount());
+    if (h.size() % h.every == 0) takeKeyframe(s);
+    h.deltas.push_back({ op, op.kind == OP_WRITE ? s.bars[op.a] : 0 });
+    h.liveProgress = progress;
+}
+
+// Invert the event before s.stepIdx in place.  Range marks, and events
+// whose lane-0 highlight came from another lane, go through a keyframe.
+static bool undoOp(SortState& s)
+{
+    const auto& d = s.hist.deltas;
+    long long t = s.stepIdx - 1;
+    if (s.hist.file) return false;           // files store no old values
+    const Delta& e = d[t];
+    if (e.op.lane != 0 || (t > 0 && d[t - 1].op.lane != 0)) return false;
+
+    switch (e.op.kind) {
+    case OP_COMPARE:
+        s.comparisons--;
+        break;
+    case OP_SWAP:
+        std::swap(s.bars[e.op.a], s.bars[e.op.b]);
+        touchValue(s, e.op.a);
+        touchValue(s, e.op.b);
+        s.swaps--;
+        break;
+    case OP_WRITE:
+        s.bars[e.op.a] = e.old;
+        touchValue(s, e.op.a);
+        s.swaps--;
+        break;
+    case OP_READ:
+    case OP_LOAD:
+        break;
+    default:
+        return false;
+    }
+
+    // Light what the previous event lit
+    resetColors(s, 0);
+    if (t > 0) lightOp(s, d[t - 1].op);
+    s.stepIdx = t;
+    return true;
+}
+
+// Move the replay to just before recorded event t
+static void seekTo(SortState& s, long long t)
+{
+    History& h = s.hist;
+    if (!h.usable()) return;
+    t = std::max(0LL, std::min(t, h.size()));
+    if (t == s.stepIdx) return;
+
+    // Scrubbing is not memory traffic
+    bool probe = s.mem.on;
+    s.mem.on = false;
+
+    // Replay forward from here unless the keyframe is nearer.  A keyframe
+    // is taken before the event it precedes, so at t = size() with size a
+    // multiple of K the last one is K events back.
+    if (s.finished || t != s.stepIdx - 1 || !undoOp(s)) {
+        if (s.finished || s.stepIdx > t || t - s.stepIdx > h.every)
+            restoreKeyframe(s, std::min((size_t)(t / h.every), h.keyCount() - 1));
+        t = std::min(t, h.size());           // a damaged keyframe cuts it
+        Op op{};
+        while (s.stepIdx < t) {
+            if (!h.file) op = h.deltas[s.stepIdx].op;
+            else if (!h.file->next(h.cur, op)) {
+                cutTrace(h, s.stepIdx);
+                t = s.stepIdx;
+                break;
+            }
+            applyOp(s, op);
+            s.stepIdx++;
+        }
+    }
+
+    s.mem.on = probe;
+    s.finished = false;
+    s.progress = h.liveProgress * (float)((double)t / h.size());
+}
+
+// Play recorded events forward after a seek back: at most maxEvents, and
+// stop early once budgetSec has elapsed.  True at the run's end.
+static bool redoEvents(SortState& s, long long maxEvents, double budgetSec)
+{
+    using Clock = std::chrono::steady_clock;
+    auto  t0 = Clock::now();
+    const History& h = s.hist;
+
+    long long left = std::min(maxEvents, h.size() - s.stepIdx);
+    while (left > 0) {
+        long long k = std::min(left, 4096LL);   // ≤ h.every: no keyframe hop
+        seekTo(s, s.stepIdx + k);
+        left -= k;
+        if (std::chrono::duration<double>(Clock::now() - t0).count()
+            > budgetSec)
+            break;
+    }
+    return h.complete && s.stepIdx == h.size();
+}
+
+//  Sort engines
+
+// ── Bubble Sort ────────
+struct BubbleEngine : Engine {
+    int n, i = 0, j = 0;
+
+    BubbleEngine(const std::vector<int>& b,
+        std::pmr::memory_resource* mr)
+        : Engine(b, mr), n((int)b.size()) {}
+
+    bool step() override
+    {
+        if (i >= n - 1) return false;
+
+        if (j < n - 1 - i) {
+            emit(OP_COMPARE, j, j + 1);
+            if (a[j] > a[j + 1]) {
+                std::swap(a[j], a[j + 1]);
+                emit(OP_SWAP, j, j + 1);
+            }
+            j++;
+        }
+        else {
+            emit(OP_SORTED, n - 1 - i, n - 1 - i);
+            i++;
+            j = 0;
+        }
+        return true;
+    }
+
+    float progress() const override
+    {
+        // comparisons done / n(n-1)/2
+        double total = 0.5 * n * (n - 1);
+        double done = i * (n - 1.0) - 0.5 * i * (i - 1.0) + j;
+        return total > 0 ? (float)(done / total) : 1.f;
+    }
+};
+
+// ── Selection Sort ───────────────────
+struct SelectionEngine : Engine {
+    int n, i = 0, j = 1, mi = 0;
+
+    SelectionEngine(const std::vector<int>& b,
+        std::pmr::memory_resource* mr)
+        : Engine(b, mr), n((int)b.size()) {}
+
+    bool step() override
+    {
+        if (i >= n - 1) return false;
+
+        if (j < n) {
+            emit(OP_COMPARE, j, mi);
+            if (a[j] < a[mi]) mi = j;
+            j++;
+        }
+        else {
+            if (mi != i) {
+                std::swap(a[i], a[mi]);
+                emit(OP_SWAP, i, mi);
+            }
+            emit(OP_SORTED, i, i);
+            i++;
+            mi = i;
+            j = i + 1;
+        }
+        return true;
+    }
+
+    float progress() const override
+    {
+        double total = 0.5 * n * (n - 1);
+        double done = i * (n - 1.0) - 0.5 * i * (i - 1.0) + (j - i - 1);
+        return total > 0 ? (float)(done / total) : 1.f;
+    }
+};
+
+// ── Insertion Sort ───────────
+//  InsertionPass sorts one range, one compare per step; IntroEngine
+//  reuses it for its small ranges.
+struct InsertionPass {
+    int lo = 0, hi = -1, i = 1, j = 1;
+
+    void begin(int l, int r) { lo = l; hi = r; i = j = l + 1; }
+
+    // False once [lo, hi] is sorted
+    template <typename Emit>
+    bool step(IntBuf& a, Emit&& emit)
+    {
+        if (i > hi) return false;
+
+        if (j > lo) {
+            emit(OP_COMPARE, j - 1, j);
+            if (a[j - 1] > a[j]) {
+                std::swap(a[j - 1], a[j]);
+                emit(OP_SWAP, j - 1, j);
+                j--;
+                return true;
+            }
+        }
+        i++;
+        j = i;
+        return true;
+    }
+};
+
+struct InsertionEngine : Engine {
+    int n;
+    InsertionPass pass;
+
+    InsertionEngine(const std::vector<int>& b,
+        std::pmr::memory_resource* mr)
+        : Engine(b, mr), n((int)b.size())
+    {
+        pass.begin(0, n - 1);
+    }
+
+    bool step() override { return pass.step(a, sink()); }
+
+    float progress() const override
+    {
+        // Work up to row i grows ~ i² on random input
+        float f = n > 1 ? (float)std::min(pass.i, n) / n : 1.f;
+        return f * f;
+    }
+};
+
+// ── Merge Sort (iterative, bottom-up) ──────
+struct MergeEngine : Engine {
+    int n, w = 1, blk = 0;
+    int l = 0, m = 0, r = -1;     // current merge [l, m] + [m+1, r]
+    int i2 = 0, j2 = 0, k = 0;    // cursors into tmp and a
+    int levels = 0, level = 0;
+    IntBuf tmp{ mem() };
+
+    MergeEngine(const std::vector<int>& b,
+        std::pmr::memory_resource* mr)
+        : Engine(b, mr), n((int)b.size())
+    {
+        tmp.reserve(n);
+        for (int x = 1; x < n; x *= 2) levels++;
+    }
+
+    bool step() override
+    {
+        // Between merges: pick the next block pair with a non-empty right
+        if (k > r) {
+            if (w >= n) return false;
+
+            l = blk;
+            m = std::min(blk + w - 1, n - 1);
+            r = std::min(blk + 2 * w - 1, n - 1);
+            blk += 2 * w;
+            if (blk >= n) { blk = 0; w *= 2; level++; }
+
+            if (m >= r) { k = r + 1; return true; }
+
+            tmp.assign(a.begin() + l, a.begin() + r + 1);
+            emit(OP_LOAD, l, r);
+            i2 = 0;
+            j2 = m - l + 1;
+            k = l;
+        }
+
+        int v;
+        if (i2 <= m - l && j2 <= r - l) {
+            emit(OP_COMPARE, l + i2, l + j2);
+            v = (tmp[i2] <= tmp[j2]) ? tmp[i2++] : tmp[j2++];
+        }
+        else if (i2 <= m - l) v = tmp[i2++];
+        else                  v = tmp[j2++];
+
+        a[k] = v;
+        emit(OP_WRITE, k++, v);
+        return true;
+    }
+
+    float progress() const override
+    {
+        if (levels == 0) return 1.f;
+        float within = (float)std::min(blk, n) / n;
+        return std::min(1.f, (level + within) / levels);
+    }
+
+    size_t auxBytes() const override { return tmp.capacity() * sizeof(int); }
+};
+
+// ── Quick Sort (iterative) ─────────────
+//  PartitionPass splits one range.  Pivot rule and scheme come from
+//  EngineOptions: Lomuto keeps the pivot at r and places it after the
+//  scan; branchless Lomuto swaps unconditionally and advances by the
+//  comparison result; Hoare scans from both ends around a pivot kept at l
+//  and places nothing; the block scheme is the SIMD kernel emulated one
+//  vector at a time — a block of PART_BLOCK_W keys is loaded, compared
+//  once, its small keys packed in place and its large keys set aside,
+//  then written back behind the pivot.
+struct PartitionPass {
+    PivotRule       rule = PIVOT_LAST;
+    PartitionScheme scheme = PART_LOMUTO;
+
+    int  l = 0, r = -1, j = 0, i2 = 0, pivot = 0;
+    int  stage = 0;               // 0 pick pivot · 1 scan · 2 write-back
+    bool scanHigh = false;        // Hoare: scanning down from the right
+    IntBuf high;                  // block scheme: keys > pivot, in order
+    size_t highAt = 0;
+
+    // Result: [l, loEnd] and [hiStart, r] remain; pivotAt = -1 for Hoare
+    int loEnd = 0, hiStart = 0, pivotAt = -1;
+
+    explicit PartitionPass(std::pmr::memory_resource* mr) : high(mr) {}
+
+    void begin(int lo, int hi) { l = lo; r = hi; stage = 0; }
+
+    // Index of the median of a[x], a[y], a[z]; at most three compares
+    template <typename Emit>
+    static int median3(const IntBuf& a, int x, int y, int z,
+        Emit& emit)
+    {
+        emit(OP_COMPARE, x, y);
+        if (a[y] < a[x]) std::swap(x, y);
+        emit(OP_COMPARE, y, z);
+        if (a[z] >= a[y]) return y;
+        emit(OP_COMPARE, x, z);
+        return a[z] < a[x] ? x : z;
+    }
+
+    template <typename Emit>
+    int choosePivot(const IntBuf& a, Emit& emit) const
+    {
+        int len = r - l + 1;
+        int m = l + len / 2;
+        if (rule == PIVOT_LAST || len < 3) return r;
+        if (rule == PIVOT_MEDIAN3 || len < NINTHER_MIN)
+            return median3(a, l, m, r, emit);
+
+        int s = len / 8;
+        int m1 = median3(a, l, l + s, l + 2 * s, emit);
+        int m2 = median3(a, m - s, m, m + s, emit);
+        int m3 = median3(a, r - 2 * s, r - s, r, emit);
+        return median3(a, m1, m2, m3, emit);
+    }
+
+    void finish(int p)
+    {
+        pivotAt = p;
+        loEnd = p - 1;
+        hiStart = p + 1;
+    }
+
+    // False once the range is split (the first call only picks the pivot)
+    template <typename Emit>
+    bool step(IntBuf& a, Emit&& emit)
+    {
+        if (stage == 0) {
+            // Hoare keeps the pivot at the left end, the rest at the right
+            int pi = choosePivot(a, emit);
+            int home = scheme == PART_HOARE ? l : r;
+            if (pi != home) {
+                std::swap(a[pi], a[home]);
+                emit(OP_SWAP, pi, home);
+            }
+            pivot = a[home];
+
+            i2 = scheme == PART_LOMUTO || scheme == PART_HOARE ? l - 1 : l;
+            j = scheme == PART_HOARE ? r + 1 : l;
+            scanHigh = false;
+            high.clear();
+            stage = 1;
+            return true;
+        }
+
+        if (stage == 2) {
+            // Block scheme: the set-aside large keys go behind the pivot
+            if (highAt < high.size()) {
+                int k = i2 + 1 + (int)highAt;
+                a[k] = high[highAt++];
+                emit(OP_WRITE, k, a[k]);
+                return true;
+            }
+            finish(i2);
+            return false;
+        }
+
+        switch (scheme) {
+        case PART_LOMUTO:
+            if (j < r) {
+                emit(OP_COMPARE, j, r);
+                if (a[j] <= pivot) {
+                    i2++;
+                    if (i2 != j) {
+                        std::swap(a[i2], a[j]);
+                        emit(OP_SWAP, i2, j);
+                    }
+                }
+                j++;
+                return true;
+            }
+            i2++;
+            if (i2 != r) {
+                std::swap(a[i2], a[r]);
+                emit(OP_SWAP, i2, r);
+            }
+            finish(i2);
+            return false;
+
+        case PART_BRANCHLESS:
+            // [l, i2) <= pivot < [i2, j): the swap happens either way
+            if (j < r) {
+                emit(OP_COMPARE, j, r);
+                int small = a[j] <= pivot;
+                if (i2 != j) {
+                    std::swap(a[i2], a[j]);
+                    emit(OP_SWAP, i2, j);
+                }
+                i2 += small;
+                j++;
+                return true;
+            }
+            if (i2 != r) {
+                std::swap(a[i2], a[r]);
+                emit(OP_SWAP, i2, r);
+            }
+            finish(i2);
+            return false;
+
+        case PART_HOARE:
+            if (!scanHigh) {
+                i2++;
+                emit(OP_COMPARE, i2, l);
+                if (!(a[i2] < pivot)) scanHigh = true;
+                return true;
+            }
+            j--;
+            emit(OP_COMPARE, j, l);
+            if (a[j] > pivot) return true;
+            if (i2 >= j) {
+                // Split at j; nothing is final yet
+                pivotAt = -1;
+                loEnd = j;
+                hiStart = j + 1;
+                return false;
+            }
+            std::swap(a[i2], a[j]);
+            emit(OP_SWAP, i2, j);
+            scanHigh = false;
+            return true;
+
+        case PART_BLOCK:
+        default:
+            if (j < r) {
+                int w = std::min(PART_BLOCK_W, r - j);
+                int blk[PART_BLOCK_W];
+                std::copy(a.begin() + j, a.begin() + j + w, blk);
+                emit(OP_LOAD, j, j + w - 1);
+                emit(OP_COMPARE, j, r);          // one vector compare
+                for (int k = 0; k < w; k++) {
+                    if (blk[k] <= pivot) {
+                        a[i2] = blk[k];
+                        emit(OP_WRITE, i2, blk[k]);
+                        i2++;
+                    }
+                    else high.push_back(blk[k]);
+                }
+                j += w;
+                return true;
+            }
+            a[i2] = pivot;
+            emit(OP_WRITE, i2, pivot);
+            highAt = 0;
+            stage = 2;
+            return true;
+        }
+    }
+};
+
+struct QuickEngine : Engine {
+    struct Range { int l, r; };
+
+    int n;
+    std::pmr::vector<Range> work{ mem() };
+    PartitionPass part{ mem() };
+    bool partitioning = false;
+    int  placed = 0;              // elements in their final slot
+
+    QuickEngine(const std::vector<int>& b, const EngineOptions& o,
+        std::pmr::memory_resource* mr)
+        : Engine(b, mr), n((int)b.size())
+    {
+        part.rule = o.pivot;
+        part.scheme = o.partition;
+        work.push_back({ 0, n - 1 });
+    }
+
+    bool step() override
+    {
+        if (partitioning) {
+            if (part.step(a, sink())) return true;
+
+            if (part.pivotAt >= 0) {
+                emit(OP_SORTED, part.pivotAt, part.pivotAt);
+                placed++;
+            }
+            work.push_back({ part.l,       part.loEnd });
+            work.push_back({ part.hiStart, part.r });
+            partitioning = false;
+            return true;
+        }
+
+        if (work.empty()) return false;
+
+        Range wr = work.back();
+        work.pop_back();
+
+        if (wr.l > wr.r) return true;
+        if (wr.l == wr.r) {
+            emit(OP_SORTED, wr.l, wr.l);
+            placed++;
+            return true;
+        }
+
+        part.begin(wr.l, wr.r);
+        part.step(a, sink());             // picks the pivot
+        partitioning = true;
+        return true;
+    }
+
+    float progress() const override
+    {
+        return n > 0 ? (float)placed / n : 1.f;
+    }
+
+    size_t auxBytes() const override
+    {
+        return work.capacity() * sizeof(Range)
+            + part.high.capacity() * sizeof(int);
+    }
+};
+
+// ── Heap Sort (d-ary) ───────────────────────────────────
+//  HeapPass heap-sorts the count keys starting at base; IntroEngine uses
+//  it as its depth-limit fallback.  Every sift-down exchange is recorded
+//  as a swap, so the trace is a pure delta stream.  One step() handles
+//  one level of a sift-down.  With d = 4 the tree is half as deep and a
+//  node's children share a cache line, at the cost of more comparisons
+//  per level.
+struct HeapPass {
+    int  base = 0, count = 0, d = 2;
+    int  buildAt = -1;            // next node to heapify (build phase)
+    int  heapEnd = 0;             // heap occupies [0, heapEnd)
+    int  node = -1;               // node being sifted, -1 = idle
+    bool closed = true;           // last key reported final
+
+    void begin(int b, int c, int arity)
+    {
+        base = b;
+        count = c;
+        d = arity;
+        buildAt = c > 1 ? (c - 2) / arity : -1;
+        heapEnd = c;
+        node = -1;
+        closed = c <= 0;
+    }
+
+    // False once the range is sorted
+    template <typename Emit>
+    bool step(IntBuf& v, Emit&& emit)
+    {
+        int* a = v.data() + base;
+
+        if (node >= 0) {
+            int lg = node;
+            int first = d * node + 1;
+            int last = std::min(first + d, heapEnd);
+
+            for (int c = first; c < last; c++) {
+                emit(OP_COMPARE, base + c, base + lg);
+                if (a[c] > a[lg]) lg = c;
+            }
+
+            if (lg != node) {
+                std::swap(a[node], a[lg]);
+                emit(OP_SWAP, base + node, base + lg);
+                node = lg;
+            }
+            else node = -1;
+            return true;
+        }
+
+        // Build max-heap
+        if (buildAt >= 0) {
+            node = buildAt--;
+            return true;
+        }
+
+        // Extract elements one by one
+        if (heapEnd > 1) {
+            heapEnd--;
+            std::swap(a[0], a[heapEnd]);
+            emit(OP_SWAP, base, base + heapEnd);
+            emit(OP_SORTED, base + heapEnd, base + heapEnd);
+            node = 0;
+            return true;
+        }
+        if (!closed) {
+            emit(OP_SORTED, base, base);
+            closed = true;
+            return true;
+        }
+        return false;
+    }
+};
+
+struct HeapEngine : Engine {
+    int      n;
+    HeapPass pass;
+
+    HeapEngine(const std::vector<int>& b, int arity,
+        std::pmr::memory_resource* mr)
+        : Engine(b, mr), n((int)b.size())
+    {
+        pass.begin(0, n, arity);
+    }
+
+    bool step() override { return pass.step(a, sink()); }
+
+    float progress() const override
+    {
+        return n > 1 ? (float)(n - pass.heapEnd) / (n - 1) : 1.f;
+    }
+};
+
+// ── Intro Sort ───────────────────────────────
+//  Quick Sort (at least median-of-3, with the selected partition scheme)
+//  plus two fallbacks built from the passes above: ranges of at most
+//  introCutoff keys are finished by insertion sort, and a range still
+//  being partitioned introDepth·⌊log2 n⌋ levels down is heap sorted.
+//  Each fallback is announced with an OP_MARK_* event so the view can
+//  show where it fired.
+struct IntroEngine : Engine {
+    struct Range { int l, r, depth; };
+
+    int n, cutoff, depthLimit, arity;
+    std::pmr::vector<Range> work{ mem() };
+    PartitionPass part{ mem() };
+    InsertionPass ins;
+    HeapPass      heap;
+    int  mode = 0;                // 0 next range · 1 partition · 2 insertion · 3 heap
+    int  depth = 0;               // of the range being partitioned
+    long long settled = 0;        // keys final so far
+
+    IntroEngine(const std::vector<int>& b, const EngineOptions& o,
+        std::pmr::memory_resource* mr)
+        : Engine(b, mr), n((int)b.size()), cutoff(o.introCutoff),
+          arity(o.heapArity)
+    {
+        int lg = 0;
+        while ((1 << (lg + 1)) <= std::max(1, n)) lg++;
+        depthLimit = o.introDepth * lg;
+
+        part.rule = o.pivot == PIVOT_LAST ? PIVOT_MEDIAN3 : o.pivot;
+        part.scheme = o.partition;
+        work.push_back({ 0, n - 1, 0 });
+    }
+
+    bool step() override
+    {
+        switch (mode) {
+        case 1:
+            if (part.step(a, sink())) return true;
+            if (part.pivotAt >= 0) {
+                emit(OP_SORTED, part.pivotAt, part.pivotAt);
+                settled++;
+            }
+            work.push_back({ part.l,       part.loEnd, depth + 1 });
+            work.push_back({ part.hiStart, part.r,     depth + 1 });
+            mode = 0;
+            return true;
+
+        case 2:
+            if (ins.step(a, sink())) return true;
+            emit(OP_SORTED, ins.lo, ins.hi);
+            settled += ins.hi - ins.lo + 1;
+            mode = 0;
+            return true;
+
+        case 3:
+            if (heap.step(a, sink())) return true;
+            settled += heap.count;
+            mode = 0;
+            return true;
+        }
+
+        if (work.empty()) return false;
+
+        Range wr = work.back();
+        work.pop_back();
+        int len = wr.r - wr.l + 1;
+
+        if (len <= 0) return true;
+        if (len == 1) {
+            emit(OP_SORTED, wr.l, wr.l);
+            settled++;
+        }
+        else if (len <= cutoff) {
+            emit(OP_MARK_INSERTION, wr.l, wr.r);
+            ins.begin(wr.l, wr.r);
+            mode = 2;
+        }
+        else if (wr.depth >= depthLimit) {
+            emit(OP_MARK_HEAP, wr.l, wr.r);
+            heap.begin(wr.l, len, arity);
+            mode = 3;
+        }
+        else {
+            depth = wr.depth;
+            part.begin(wr.l, wr.r);
+            part.step(a, sink());         // picks the pivot
+            mode = 1;
+        }
+        return true;
+    }
+
+    float progress() const override
+    {
+        return n > 0 ? (float)settled / n : 1.f;
+    }
+
+    size_t auxBytes() const override
+    {
+        return work.capacity() * sizeof(Range)
+            + part.high.capacity() * sizeof(int);
+    }
+};
+
+// Digit width for LSD radix over keys up to maxV: the fewest passes of at
+// most 11 bits, with the bits spread evenly (24-bit keys → 3 × 8,
+// 20-bit → 2 × 10).  Keys are non-negative.
+static int radixBits(int maxV, int& passes)
+{
+    int bits = 1;
+    while (bits < 31 && (maxV >> bits)) bits++;
+    passes = (bits + 10) / 11;
+    return (bits + passes - 1) / passes;
+}
+
+// ── Radix Sort (LSD, histogram then scatter) ─────
+//  One read of the input fills every pass's digit histogram; each pass
+//  then scatters the previous pass's output into the bars.  Keys that fit
+//  a single digit are split into two passes so the LSD order shows.
+struct RadixEngine : Engine {
+    int  n, bits, passes;
+    int  pass = -1;               // scatter pass in progress
+    int  i = 0;                   // cursor within the current phase
+    bool reading = true;          // histogram read, then scatter passes
+    IntBuf src{ mem() };          // previous pass's output
+    IntBuf hist{ mem() };         // passes × buckets, then bucket starts
+
+    RadixEngine(const std::vector<int>& b,
+        std::pmr::memory_resource* mr)
+        : Engine(b, mr), n((int)b.size())
+    {
+        int maxV = n ? *std::max_element(a.begin(), a.end()) : 0;
+        bits = radixBits(maxV, passes);
+        if (passes == 1 && bits > 1) { passes = 2; bits = (bits + 1) / 2; }
+        hist.assign((size_t)passes << bits, 0);
+    }
+
+    int digit(int v, int p) const { return (v >> (p * bits)) & ((1 << bits) - 1); }
+
+    // Every key has the same digit in pass p, so the pass is a no-op
+    bool trivial(int p) const
+    {
+        const int* h = &hist[(size_t)p << bits];
+        int d = digit(a[0], p);
+        return h[d] == 0 && (d == (1 << bits) - 1 || h[d + 1] == n);
+    }
+
+    bool step() override
+    {
+        if (reading) {
+            if (i < n) {
+                emit(OP_READ, i, 0);
+                for (int p = 0; p < passes; p++)
+                    hist[((size_t)p << bits) + digit(a[i], p)]++;
+                i++;
+                return true;
+            }
+            // Counts → exclusive prefix sums (each bucket's first slot)
+            for (int p = 0; p < passes; p++) {
+                int* h = &hist[(size_t)p << bits];
+                for (int d = 0, sum = 0; d < (1 << bits); d++) {
+                    int c = h[d];
+                    h[d] = sum;
+                    sum += c;
+                }
+            }
+            reading = false;
+        }
+
+        if (i == n) {
+            if (n == 0) return false;
+            do pass++; while (pass < passes && trivial(pass));
+            if (pass >= passes) return false;
+            src = a;
+            emit(OP_LOAD, 0, n - 1);
+            i = 0;
+        }
+
+        int v = src[i++];
+        int k = hist[((size_t)pass << bits) + digit(v, pass)]++;
+        a[k] = v;
+        emit(OP_WRITE, k, v);
+        return true;
+    }
+
+    float progress() const override
+    {
+        if (n == 0) return 1.f;
+        float done = reading ? (float)i : (float)n * (pass + 1) + i;
+        return std::min(1.f, done / ((float)n * (passes + 1)));
+    }
+
+    size_t auxBytes() const override
+    {
+        return (src.capacity() + hist.capacity()) * sizeof(int);
+    }
+};
+
+// ── Counting Sort ──────────────────────
+//  One read tallies every key in [lo, hi]; the bars are then rewritten in
+//  order straight from the tallies.  O(n + k), k = hi - lo + 1.
+struct CountingEngine : Engine {
+    int n, lo = 0;
+    int i = 0;                    // read cursor
+    int v = 0, k = 0;             // tally being written, output slot
+    IntBuf count{ mem() };
+
+    CountingEngine(const std::vector<int>& b,
+        std::pmr::memory_resource* mr)
+        : Engine(b, mr), n((int)b.size())
+    {
+        if (n == 0) return;
+        auto mm = std::minmax_element(a.begin(), a.end());
+        lo = *mm.first;
+        count.assign((size_t)(*mm.second - lo) + 1, 0);
+    }
+
+    bool step() override
+    {
+        if (i < n) {
+            emit(OP_READ, i, 0);
+            count[a[i++] - lo]++;
+            return true;
+        }
+
+        while (v < (int)count.size() && count[v] == 0) v++;
+        if (v >= (int)count.size()) return false;
+
+        count[v]--;
+        a[k] = v + lo;
+        emit(OP_WRITE, k, v + lo);
+        emit(OP_SORTED, k, k);
+        k++;
+        return true;
+    }
+
+    float progress() const override
+    {
+        return n > 0 ? (float)(i + k) / (2.f * n) : 1.f;
+    }
+
+    size_t auxBytes() const override { return count.capacity() * sizeof(int); }
+};
+
+// Bucket for key v when [lo, lo + span) is cut into nb equal ranges
+static inline int bucketOf(int v, int lo, long long span, int nb)
+{
+    return (int)((long long)(v - lo) * nb / span);
+}
+
+// ── Bucket Sort ─────────────────────────
+//  Keys are spread over ~n/8 equal-width buckets.  One read sizes the
+//  buckets, a scatter drops every key into its bucket's slot range, and
+//  insertion sort finishes each bucket in place.  Expected O(n) on
+//  uniform keys.
+struct BucketEngine : Engine {
+    int       n, lo = 0, nb = 1;
+    long long span = 1;
+    int       phase = 0;          // 0 read · 1 scatter · 2 insertion
+    int       i = 0, j = 0;       // phase cursor / insertion position
+    int       b = 0;              // bucket being finished
+    IntBuf start{ mem() };        // bucket b owns [start[b], start[b + 1])
+    IntBuf fill{ mem() };         // scatter cursor per bucket
+    IntBuf src{ mem() };
+
+    BucketEngine(const std::vector<int>& bs,
+        std::pmr::memory_resource* mr)
+        : Engine(bs, mr), n((int)bs.size())
+    {
+        if (n == 0) return;
+        auto mm = std::minmax_element(a.begin(), a.end());
+        lo = *mm.first;
+        span = (long long)*mm.second - lo + 1;
+        nb = std::max(1, n / 8);
+        start.assign(nb + 1, 0);
+    }
+
+    bool step() override
+    {
+        if (phase == 0) {
+            if (i < n) {
+                emit(OP_READ, i, 0);
+                start[bucketOf(a[i++], lo, span, nb) + 1]++;
+                return true;
+            }
+            if (n == 0) return false;
+            std::partial_sum(start.begin(), start.end(), start.begin());
+            fill.assign(start.begin(), start.end() - 1);
+            src = a;
+            emit(OP_LOAD, 0, n - 1);
+            phase = 1;
+            i = 0;
+        }
+
+        if (phase == 1) {
+            if (i < n) {
+                int v = src[i++];
+                int k = fill[bucketOf(v, lo, span, nb)]++;
+                a[k] = v;
+                emit(OP_WRITE, k, v);
+                return true;
+            }
+            IntBuf(mem()).swap(src);
+            IntBuf(mem()).swap(fill);
+            phase = 2;
+            b = 0;
+            i = j = start[0] + 1;
+        }
+
+        // Insertion sort inside bucket b, one compare per step
+        if (b < nb && i >= start[b + 1]) {
+            if (start[b + 1] > start[b])
+                emit(OP_SORTED, start[b], start[b + 1] - 1);
+            b++;
+            if (b < nb) i = j = start[b] + 1;
+            return true;
+        }
+        if (b >= nb) return false;
+
+        if (j > start[b]) {
+            emit(OP_COMPARE, j - 1, j);
+            if (a[j - 1] > a[j]) {
+                std::swap(a[j - 1], a[j]);
+                emit(OP_SWAP, j - 1, j);
+                j--;
+                return true;
+            }
+        }
+        i++;
+        j = i;
+        return true;
+    }
+
+    float progress() const override
+    {
+        if (n == 0) return 1.f;
+        if (phase < 2) return (phase * n + i) / (3.f * n);
+        return (2.f * n + (b < nb ? start[b] : n)) / (3.f * n);
+    }
+
+    size_t auxBytes() const override
+    {
+        return (start.capacity() + fill.capacity() + src.capacity())
+            * sizeof(int);
+    }
+};
+
+// ── TimSort ──────────────────────────────────
+//  Natural runs are found left to right (strictly descending ones are
+//  reversed), topped up to minRun keys by binary insertion and pushed on
+//  a run stack whose lengths are kept Fibonacci-like by merging.  A merge
+//  first gallops off the head of A and the tail of B that are already in
+//  place, copies the shorter run into the one scratch buffer and merges
+//  from that side.  After minGallop wins in a row by one side it gallops:
+//  an exponential search for how far that side runs, then a bulk copy.
+//  Every new or merged run is announced with OP_MARK_RUN.
+static const int TIM_MIN_MERGE = 32;
+static const int TIM_MIN_GALLOP = 7;
+
+// Run length: n / 2^k in [MIN_MERGE / 2, MIN_MERGE], rounded up
+static int timMinRun(int n)
+{
+    int r = 0;
+    while (n >= TIM_MIN_MERGE) { r |= n & 1; n >>= 1; }
+    return n + r;
+}
+
+// Insertion point of key in a sorted range, one probe per step.  Probes
+// double away from one end (fromEnd picks which), then bisect.  left
+// puts key before equal elements.  src may be the scratch buffer, so
+// events name the probe as evBase + offset
+struct GallopPass {
+    const int* src = nullptr;
+    int  evBase = 0, key = 0, keyAt = 0;
+    bool left = false, fromEnd = false, expo = true;
+    int  lo = 0, hi = 0, ofs = 1;
+
+    void begin(const int* s, int eb, int len, int k, int kAt, bool l, bool fe)
+    {
+        src = s; evBase = eb; key = k; keyAt = kAt;
+        left = l; fromEnd = fe; expo = true;
+        lo = 0; hi = len; ofs = 1;
+    }
+
+    // False once lo is the insertion point
+    template <typename Emit>
+    bool step(Emit&& emit)
+    {
+        if (lo >= hi) return false;
+
+        int p = !expo ? lo + (hi - lo) / 2
+            : fromEnd ? std::max(lo, hi - ofs)
+            : std::min(hi - 1, lo + ofs - 1);
+        emit(OP_COMPARE, evBase + p, keyAt);
+        bool before = left ? src[p] < key : src[p] <= key;
+        if (before) lo = p + 1;
+        else        hi = p;
+
+        if (before == fromEnd) expo = false;   // overshot: bisect
+        else ofs *= 2;
+        return true;
+    }
+};
+
+struct TimEngine : Engine {
+    struct Run { int base, len; };
+
+    enum Stage { FIND, SCAN, REVERSE, EXTEND, BSEARCH, SHIFT, COLLAPSE,
+                 TRIM_A, TRIM_B, MERGE };
+    enum MergeStage { CMP, GALLOP_A, COPY_A, GALLOP_B, COPY_B, TAIL };
+
+    int  n, minRun;
+    Stage stage = FIND;
+    std::pmr::vector<Run> runs{ mem() };
+    IntBuf tmp{ mem() };                // the shorter run of a merge
+
+    int  lo = 0, hi = 0;                // run being built: [lo, hi)
+    bool desc = false;
+    int  ri = 0, rj = 0;                // reversal cursors
+    int  bl = 0, br = 0, sh = 0, key = 0;   // binary insertion
+
+    int  at = 0;                        // merging runs[at] and runs[at + 1]
+    int  baseA = 0, lenA = 0, baseB = 0, lenB = 0;
+    bool fromHigh = false;              // B in tmp, merged right to left
+    MergeStage ms = CMP;
+    int  pa = 0, pb = 0, dest = 0;      // A / B cursors (one is in tmp)
+    int  winA = 0, winB = 0, copyLeft = 0;
+    int  minGallop = TIM_MIN_GALLOP;
+    GallopPass g;
+
+    long long moved = 0, expected = 1;  // progress estimate
+
+    TimEngine(const std::vector<int>& b,
+        std::pmr::memory_resource* mr)
+        : Engine(b, mr), n((int)b.size()), minRun(timMinRun((int)b.size()))
+    {
+        int levels = 1;
+        for (int x = minRun; x < n; x *= 2) levels++;
+        expected = std::max(1LL, (long long)n * levels);
+    }
+
+    // Merge setup pops runs[k + 1] into runs[k] and trims both ends
+    void startMerge(int k)
+    {
+        at = k;
+        baseA = runs[k].base;     lenA = runs[k].len;
+        baseB = runs[k + 1].base; lenB = runs[k + 1].len;
+        runs[k].len += lenB;
+        runs.erase(runs.begin() + k + 1);
+
+        // A's head that is <= B[0] is already in place
+        g.begin(a.data() + baseA, baseA, lenA, a[baseB], baseB, false, false);
+        stage = TRIM_A;
+    }
+
+    void finishMerge()
+    {
+        emit(OP_MARK_RUN, runs[at].base, runs[at].base + runs[at].len - 1);
+        stage = COLLAPSE;
+    }
+
+    // Which pair to merge next, or -1 once the stack invariants hold
+    // (force: the input is exhausted, merge down to one run)
+    int pickMerge(bool force) const
+    {
+        int sz = (int)runs.size();
+        if (sz < 2) return -1;
+        int k = sz - 2;
+        auto L = [this](int i) { return runs[i].len; };
+
+        if (force) return k > 0 && L(k - 1) < L(k + 1) ? k - 1 : k;
+        if ((k > 0 && L(k - 1) <= L(k) + L(k + 1))
+            || (k > 1 && L(k - 2) <= L(k - 1) + L(k)))
+            return L(k - 1) < L(k + 1) ? k - 1 : k;
+        return L(k) <= L(k + 1) ? k : -1;
+    }
+
+    void put(int v)
+    {
+        a[dest] = v;
+        emit(OP_WRITE, dest, v);
+        dest += fromHigh ? -1 : 1;
+        moved++;
+    }
+
+    int remA() const { return fromHigh ? pa - baseA + 1 : lenA - pa; }
+    int remB() const { return fromHigh ? pb + 1 : baseB + lenB - pb; }
+
+    // Next gallop round: how many of A go before B's current key
+    void gallopA()
+    {
+        if (remA() == 0 || remB() == 0) { ms = TAIL; return; }
+        minGallop -= minGallop > 1;
+        if (fromHigh)
+            g.begin(a.data() + baseA, baseA, remA(), tmp[pb], baseB + pb,
+                false, true);
+        else
+            g.begin(tmp.data() + pa, baseA + pa, remA(), a[pb], pb,
+                false, false);
+        ms = GALLOP_A;
+    }
+
+    // One merge step; false when the merge is complete
+    bool mergeStep()
+    {
+        switch (ms) {
+        case CMP: {
+            if (remA() == 0 || remB() == 0) { ms = TAIL; return true; }
+            bool takeA;
+            if (fromHigh) {
+                emit(OP_COMPARE, pa, baseB + pb);
+                takeA = tmp[pb] < a[pa];
+                put(takeA ? a[pa--] : tmp[pb--]);
+            }
+            else {
+                emit(OP_COMPARE, baseA + pa, pb);
+                takeA = !(a[pb] < tmp[pa]);
+                put(takeA ? tmp[pa++] : a[pb++]);
+            }
+            if (takeA) { winA++; winB = 0; }
+            else       { winB++; winA = 0; }
+            if (winA >= minGallop || winB >= minGallop) gallopA();
+            return true;
+        }
+        case GALLOP_A:
+            if (g.step(sink())) return true;
+            copyLeft = winA = fromHigh ? remA() - g.lo : g.lo;
+            ms = COPY_A;
+            return true;
+        case COPY_A:
+            if (copyLeft > 0) {
+                put(fromHigh ? a[pa--] : tmp[pa++]);
+                copyLeft--;
+                return true;
+            }
+            if (remA() == 0) { ms = TAIL; return true; }
+            put(fromHigh ? tmp[pb--] : a[pb++]);   // B's key goes next
+            if (remB() == 0) { ms = TAIL; return true; }
+            if (fromHigh)
+                g.begin(tmp.data(), baseB, remB(), a[pa], pa, true, true);
+            else
+                g.begin(a.data() + pb, pb, remB(), tmp[pa], baseA + pa,
+                    true, false);
+            ms = GALLOP_B;
+            return true;
+        case GALLOP_B:
+            if (g.step(sink())) return true;
+            copyLeft = winB = fromHigh ? remB() - g.lo : g.lo;
+            ms = COPY_B;
+            return true;
+        case COPY_B:
+            if (copyLeft > 0) {
+                put(fromHigh ? tmp[pb--] : a[pb++]);
+                copyLeft--;
+                return true;
+            }
+            if (remB() == 0) { ms = TAIL; return true; }
+            put(fromHigh ? a[pa--] : tmp[pa++]);   // A's key goes next
+            if (winA >= TIM_MIN_GALLOP || winB >= TIM_MIN_GALLOP) gallopA();
+            else { minGallop++; winA = winB = 0; ms = CMP; }
+            return true;
+        case TAIL:
+            // The run left in the array is already in place
+            if (fromHigh ? remB() > 0 : remA() > 0) {
+                put(fromHigh ? tmp[pb--] : tmp[pa++]);
+                return true;
+            }
+            return false;
+        }
+        return false;
+    }
+
+    bool step() override
+    {
+        switch (stage) {
+        case FIND:
+            if (lo >= n) {
+                int k = pickMerge(true);
+                if (k < 0) return false;
+                startMerge(k);
+                return true;
+            }
+            hi = lo + 1;
+            if (hi == n) { stage = EXTEND; return true; }
+            emit(OP_COMPARE, lo, hi);
+            desc = a[hi] < a[lo];
+            hi++;
+            stage = SCAN;
+            return true;
+
+        case SCAN:
+            if (hi < n) {
+                emit(OP_COMPARE, hi - 1, hi);
+                if (desc ? a[hi] < a[hi - 1] : a[hi] >= a[hi - 1]) {
+                    hi++;
+                    return true;
+                }
+            }
+            moved += hi - lo;
+            ri = lo; rj = hi - 1;
+            stage = desc ? REVERSE : EXTEND;
+            return true;
+
+        case REVERSE:
+            if (ri < rj) {
+                std::swap(a[ri], a[rj]);
+                emit(OP_SWAP, ri++, rj--);
+                return true;
+            }
+            stage = EXTEND;
+            return true;
+
+        case EXTEND:
+            if (hi - lo < std::min(minRun, n - lo)) {
+                key = a[hi];
+                bl = lo; br = hi;
+                stage = BSEARCH;
+                return true;
+            }
+            runs.push_back({ lo, hi - lo });
+            emit(OP_MARK_RUN, lo, hi - 1);
+            lo = hi;
+            stage = COLLAPSE;
+            return true;
+
+        case BSEARCH:
+            if (bl < br) {
+                int m = bl + (br - bl) / 2;
+                emit(OP_COMPARE, hi, m);
+                if (key < a[m]) br = m;
+                else            bl = m + 1;
+                return true;
+            }
+            sh = hi;
+            stage = SHIFT;
+            return true;
+
+        case SHIFT:
+            if (sh > bl) {
+                a[sh] = a[sh - 1];
+                emit(OP_WRITE, sh, a[sh]);
+                sh--;
+                return true;
+            }
+            a[bl] = key;
+            emit(OP_WRITE, bl, key);
+            hi++;
+            moved++;
+            stage = EXTEND;
+            return true;
+
+        case COLLAPSE: {
+            int k = pickMerge(false);
+            if (k < 0) stage = FIND;
+            else       startMerge(k);
+            return true;
+        }
+
+        case TRIM_A:
+            if (g.step(sink())) return true;
+            baseA += g.lo;
+            lenA -= g.lo;
+            moved += g.lo;
+            if (lenA == 0) { finishMerge(); return true; }
+
+            // B's tail that is >= A's last key is already in place
+            g.begin(a.data() + baseB, baseB, lenB, a[baseA + lenA - 1],
+                baseA + lenA - 1, true, true);
+            stage = TRIM_B;
+            return true;
+
+        case TRIM_B:
+            if (g.step(sink())) return true;
+            moved += lenB - g.lo;
+            lenB = g.lo;
+            if (lenB == 0) { finishMerge(); return true; }
+
+            fromHigh = lenA > lenB;
+            if (fromHigh) {
+                tmp.assign(a.begin() + baseB, a.begin() + baseB + lenB);
+                emit(OP_LOAD, baseB, baseB + lenB - 1);
+                pa = baseA + lenA - 1;
+                pb = lenB - 1;
+                dest = baseB + lenB - 1;
+            }
+            else {
+                tmp.assign(a.begin() + baseA, a.begin() + baseA + lenA);
+                emit(OP_LOAD, baseA, baseA + lenA - 1);
+                pa = 0;
+                pb = baseB;
+                dest = baseA;
+            }
+            winA = winB = 0;
+            ms = CMP;
+            stage = MERGE;
+            return true;
+
+        case MERGE:
+            if (!mergeStep()) finishMerge();
+            return true;
+        }
+        return false;
+    }
+
+    float progress() const override
+    {
+        return std::min(1.f, (float)moved / expected);
+    }
+
+    size_t auxBytes() const override
+    {
+        return tmp.capacity() * sizeof(int) + runs.capacity() * sizeof(Run);
+    }
+};
+
+// ── External Sort ───────────────────────────
+//  A two-phase external merge sort with the bars standing in for disk.
+//  Run formation cuts the array into runs of extRunSize keys and sorts
+//  each one "in memory" with a Merge or Quick Sort engine of its own,
+//  whose events are forwarded shifted to the run's position.  Merge
+//  passes then take up to extFanIn neighbouring runs at a time, read
+//  them into the scratch buffer (OP_LOAD: the run files) and write them
+//  back as one run through a loser tree: the winner is output, the next
+//  key of its run replays the matches on its leaf-to-root path, about
+//  log2 k compares per key instead of k − 1.  OP_MARK_RUN announces
+//  every finished run and OP_MARK_MERGE the group being merged.
+struct ExternalEngine : Engine {
+    struct Run { int base, len; };
+
+    int  n, runLen, fanIn;
+    EngineOptions runOpts;                // the run engines' pivot, scheme
+
+    // Run formation
+    std::unique_ptr<Engine> sub;          // sorting run `nextRun - 1`
+    int  nextRun = 0, formed = 0;
+    std::pmr::vector<Run> runs{ mem() };  // this pass's input runs
+    std::pmr::vector<Run> out{ mem() };   // and its output runs
+
+    // Merge of runs[g0, g0 + k) through a loser tree over K leaves
+    IntBuf tmp{ mem() };
+    int  g0 = 0, k = 0, K = 0, lo = 0, dest = 0;
+    int  head[EXT_FANIN_MAX], end[EXT_FANIN_MAX];
+    int  loser[EXT_FANIN_MAX], win[EXT_FANIN_MAX], build = 0, champ = -1;
+    bool merging = false;
+
+    long long moved = 0, expected = 1;    // progress estimate
+
+    ExternalEngine(const std::vector<int>& b, const EngineOptions& o,
+        std::pmr::memory_resource* mr)
+        : Engine(b, mr), n((int)b.size()), runLen(extRunLen(o, (int)b.size())),
+          fanIn(std::max(2, std::min(EXT_FANIN_MAX, o.extFanIn))),
+          runOpts(o)
+    {
+        int count = (n + runLen - 1) / runLen, passes = 0;
+        for (int c = count; c > 1; c = (c + fanIn - 1) / fanIn) passes++;
+        expected = std::max(1LL, (long long)n * (1 + passes));
+    }
+
+    bool live(int i) const { return i < k && head[i] < end[i]; }
+
+    // Winner of leaves x and y; an exhausted run loses without a compare.
+    // Ties go to the earlier run
+    int match(int x, int y)
+    {
+        if (!live(x)) return y;
+        if (!live(y)) return x;
+        emit(OP_COMPARE, lo + head[x], lo + head[y]);
+        int vx = tmp[head[x]], vy = tmp[head[y]];
+        return vy < vx || (vy == vx && y < x) ? y : x;
+    }
+
+    // Leaf or internal node's winner during the build
+    int winnerOf(int node) const { return node >= K ? node - K : win[node]; }
+
+    void startMerge()
+    {
+        k = std::min(fanIn, (int)runs.size() - g0);
+        lo = runs[g0].base;
+        const Run& last = runs[g0 + k - 1];
+        int hi = last.base + last.len - 1;
+
+        if (k == 1) {                     // odd one out: carried over
+            out.push_back({ lo, hi - lo + 1 });
+            g0++;
+            return;
+        }
+        K = 1;
+        while (K < k) K *= 2;
+        for (int i = 0; i < k; i++) {
+            head[i] = runs[g0 + i].base - lo;
+            end[i] = head[i] + runs[g0 + i].len;
+        }
+        tmp.assign(a.begin() + lo, a.begin() + hi + 1);
+        emit(OP_LOAD, lo, hi);
+        emit(OP_MARK_MERGE, lo, hi);
+        build = K - 1;
+        dest = lo;
+        merging = true;
+    }
+
+    // One build match, or one key out plus its replay up the tree
+    void mergeStep()
+    {
+        if (build >= 1) {
+            int x = winnerOf(2 * build), y = winnerOf(2 * build + 1);
+            int w = match(x, y);
+            win[build] = w;
+            loser[build] = w == x ? y : x;
+            if (--build == 0) champ = win[1];
+            return;
+        }
+
+        if (!live(champ)) {               // every run is drained
+            out.push_back({ lo, dest - lo });
+            emit(OP_MARK_RUN, lo, dest - 1);
+            g0 += k;
+            merging = false;
+            return;
+        }
+
+        a[dest] = tmp[head[champ]++];
+        emit(OP_WRITE, dest, a[dest]);
+        dest++;
+        moved++;
+        for (int node = (champ + K) / 2; node >= 1; node /= 2) {
+            int w = match(champ, loser[node]);
+            if (w != champ) std::swap(champ, loser[node]);
+        }
+    }
+
+    // Forward the run engine's next event, shifted to the run's base
+    void formStep()
+    {
+        int base = (nextRun - 1) * runLen;
+        Op op{};
+        if (!sub->next(op)) {
+            int len = std::min(runLen, n - base);
+            runs.push_back({ base, len });
+            emit(OP_MARK_RUN, base, base + len - 1);
+            formed += len;
+            moved += len;
+            sub.reset();
+            return;
+        }
+        switch (op.kind) {
+        case OP_SWAP:
+            std::swap(a[base + op.a], a[base + op.b]);
+            emit(op.kind, base + op.a, base + op.b);
+            break;
+        case OP_WRITE:
+            a[base + op.a] = op.b;
+            emit(op.kind, base + op.a, op.b);
+            break;
+        case OP_COMPARE:
+        case OP_LOAD:
+            emit(op.kind, base + op.a, base + op.b);
+            break;
+        case OP_READ:
+            emit(op.kind, base + op.a, op.b);
+            break;
+        default:                          // a run's end is not final
+            break;
+        }
+    }
+
+    bool step() override
+    {
+        if (sub) { formStep(); return true; }
+
+        if (formed < n) {
+            int base = nextRun++ * runLen;
+            std::vector<int> keys(a.begin() + base,
+                a.begin() + std::min(n, base + runLen));
+            if (runOpts.extRunQuick)
+                sub = std::make_unique<QuickEngine>(keys, runOpts, mem());
+            else          sub = std::make_unique<MergeEngine>(keys, mem());
+            return true;
+        }
+
+        if (merging) { mergeStep(); return true; }
+        if (runs.size() <= 1) return false;       // one run left: sorted
+        if (g0 < (int)runs.size()) { startMerge(); return true; }
+
+        // Pass complete: its output runs are the next pass's input
+        runs.swap(out);
+        out.clear();
+        g0 = 0;
+        return true;
+    }
+
+    float progress() const override
+    {
+        return std::min(1.f, (float)moved / expected);
+    }
+
+    size_t auxBytes() const override
+    {
+        return tmp.capacity() * sizeof(int)
+            + (runs.capacity() + out.capacity()) * sizeof(Run)
+            + (sub ? sub->auxBytes() + sizeof(int) * runLen : 0);
+    }
+};
+
+// ── Bitonic Sort ───────────────────────────
+//  Batcher's bitonic network in the form with no descending blocks:
+//  stage k (2, 4, .. K, the power of two at or above n) first compares
+//  each i with its mirror i ^ (k − 1) inside its k-block, then with
+//  i + j for j = k/4 .. 1.  A pass is K/2 independent comparators, which
+//  is what makes it the GPU's sort (see GpuBitonic); here they run one
+//  per step.  Keys past n count as +inf, so a comparator whose partner
+//  is out of range could never swap and is skipped.
+
+// Comparator t of pass (k, j): its lower index i and partner p > i
+static inline void bitonicPair(int k, int j, int t, int& i, int& p)
+{
+    i = 2 * t - (t & (j - 1));
+    p = j == k / 2 ? i ^ (k - 1) : i + j;
+}
+
+// Comparators of a (k, j) pass whose partner is below n.  Both forms
+// pair within 2j-blocks, so the count depends on j alone.
+static long long bitonicPairs(int n, int j)
+{
+    return (long long)(n / (2 * j)) * j + std::max(0, n % (2 * j) - j);
+}
+
+struct BitonicEngine : Engine {
+    int n, K = 1, k = 2, j = 1, t = 0;
+    int pass = 0, passes = 0;
+
+    BitonicEngine(const std::vector<int>& b,
+        std::pmr::memory_resource* mr)
+        : Engine(b, mr), n((int)b.size())
+    {
+        int lg = 0;
+        while (K < n) { K <<= 1; lg++; }
+        passes = lg * (lg + 1) / 2;
+    }
+
+    bool step() override
+    {
+        while (k <= K) {
+            if (t < K / 2) {
+                int i, p;
+                bitonicPair(k, j, t++, i, p);
+                if (p >= n) continue;
+                emit(OP_COMPARE, i, p);
+                if (a[p] < a[i]) {
+                    std::swap(a[i], a[p]);
+                    emit(OP_SWAP, i, p);
+                }
+                return true;
+            }
+            t = 0;
+            pass++;
+            if (j > 1) j /= 2;
+            else { k *= 2; j = k / 2; }
+        }
+        return false;
+    }
+
+    float progress() const override
+    {
+        return passes ? (pass + (float)t / (K / 2)) / passes : 1.f;
+    }
+};
+
+//  Parallel engines
+//
+//  PARALLEL_MERGE and PARALLEL_QUICK run the real sort on a work-stealing
+//  pool.  Every worker appends to its own event stream, stamped from one
+//  global counter.  A task only starts after everything it depends on has
+//  finished, so replaying the streams merged by stamp is a valid
+//  sequential execution.  Unlike the other engines the trace is recorded
+//  when the engine is created, so its memory is O(events).
+
+static thread_local int tlsWorker = -1;   // index in the running pool
+
+static int laneCount()
+{
+    int hc = (int)std::thread::hardware_concurrency();
+    return std::max(2, std::min(MAX_LANES, hc));
+}
+
+// Each worker owns a deque: it pushes and pops its own tasks LIFO and,
+// when empty, steals the oldest (largest) task from a sibling
+class WorkPool {
+public:
+    explicit WorkPool(int workers) : queues(workers)
+    {
+        for (int i = 0; i < workers; i++)
+            threads.emplace_back([this, i] { loop(i); });
+    }
+
+    ~WorkPool()
+    {
+        {
+            std::lock_guard<std::mutex> lk(idleM);
+            stop = true;
+        }
+        idleCv.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    int size() const { return (int)queues.size(); }
+
+    // Queue fn as part of the group counted by `pending`
+    void spawn(std::function<void()> fn, std::atomic<int>& pending)
+    {
+        pending++;
+        int q = tlsWorker >= 0 ? tlsWorker : 0;
+        {
+            std::lock_guard<std::mutex> lk(queues[q].m);
+            queues[q].tasks.push_back({ std::move(fn), &pending });
+        }
+        {
+            std::lock_guard<std::mutex> lk(idleM);
+            queued++;
+        }
+        idleCv.notify_one();
+    }
+
+    // Wait for a group; workers run other tasks meanwhile
+    void wait(std::atomic<int>& pending)
+    {
+        while (pending.load() > 0) {
+            if (tlsWorker >= 0 && runOne(tlsWorker)) continue;
+            if (tlsWorker >= 0) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        std::atomic<int>*     pending = nullptr;
+    };
+    struct Queue {
+        std::mutex       m;
+        std::deque<Task> tasks;
+    };
+
+    bool take(int q, bool own, Task& out)
+    {
+        std::lock_guard<std::mutex> lk(queues[q].m);
+        auto& d = queues[q].tasks;
+        if (d.empty()) return false;
+        if (own) { out = std::move(d.back());  d.pop_back(); }
+        else     { out = std::move(d.front()); d.pop_front(); }
+        return true;
+    }
+
+    bool runOne(int self)
+    {
+        Task t;
+        bool got = take(self, true, t);
+        for (int k = 1; k < size() && !got; k++)
+            got = take((self + k) % size(), false, t);
+        if (!got) return false;
+
+        queued--;
+        t.fn();
+        t.pending->fetch_sub(1);
+        return true;
+    }
+
+    void loop(int self)
+    {
+        tlsWorker = self;
+        for (;;) {
+            if (runOne(self)) continue;
+            std::unique_lock<std::mutex> lk(idleM);
+            idleCv.wait(lk, [this] { return stop || queued.load() > 0; });
+            if (stop) return;
+        }
+    }
+
+    std::vector<Queue>       queues;
+    std::vector<std::thread> threads;
+    std::mutex               idleM;
+    std::condition_variable  idleCv;
+    std::atomic<int>         queued{ 0 };
+    bool                     stop = false;
+};
+
+// Per-worker event streams with a shared ordering stamp.  A 32-bit
+// stamp keeps an event at 16 bytes; traceTooLarge() keeps runs far
+// below 2^32 events, with room for 64 an element.
+static_assert((long long)PARALLEL_TRACE_MAX * 64 < UINT_MAX,
+    "LaneTrace::seq must not wrap");
+
+struct LaneTrace {
+    struct Stamped { unsigned seq; Op op; };
+
+    // Each lane appends into its own sub-arena, so no lane waits on
+    // another's allocation.  A deque grows in fixed blocks, which a
+    // monotonic arena never has to abandon the way it would a vector's
+    std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> pools;
+    std::vector<std::pmr::deque<Stamped>> lanes;
+    std::atomic<unsigned>                  seq{ 0 };
+
+    LaneTrace(int workers, std::pmr::memory_resource* upstream)
+    {
+        lanes.reserve(workers);
+        for (int w = 0; w < workers; w++) {
+            pools.push_back(std::make_unique<std::pmr::monotonic_buffer_resource>(
+                (size_t)1 << 16, upstream));
+            lanes.emplace_back(pools.back().get());
+        }
+    }
+
+    void emit(OpKind k, int a, int b)
+    {
+        int w = tlsWorker;
+        lanes[w].push_back({ seq++, { k, (unsigned char)(w + 1), a, b } });
+    }
+};
+
+// Instrumentation as a compile-time policy.  The kernels below take the
+// probe as a template parameter and call probe.emit() at each primitive
+// operation; with NoTrace the calls inline to nothing, so the timing
+// runs (--bench, the speedup figure, native counters) compile to the
+// bare sort, and only the visual path pays for recording.
+struct NoTrace {
+    void emit(OpKind, int, int) const {}
+};
+
+struct TraceTo {
+    LaneTrace* rec;
+    void emit(OpKind k, int a, int b) const { rec->emit(k, a, b); }
+};
+
+// Ranges at or below this size are sorted by the task that owns them
+static int parCutoff(int n, int workers)
+{
+    return std::max(16, n / (workers * 8));
+}
+
+// ── Parallel Merge Sort (top-down, one task per left half) ─────
+template <typename Probe>
+struct ParMerge {
+    WorkPool&  pool;
+    Probe      probe;
+    int*       a;
+    int*       tmp;               // shared; every merge uses its own range
+    int        cutoff;
+
+    void sort(int l, int r)
+    {
+        if (l >= r) return;
+        int m = l + (r - l) / 2;
+
+        if (r - l + 1 > cutoff) {
+            std::atomic<int> pending{ 0 };
+            pool.spawn([this, l, m] { sort(l, m); }, pending);
+            sort(m + 1, r);
+            pool.wait(pending);
+        }
+        else {
+            sort(l, m);
+            sort(m + 1, r);
+        }
+        merge(l, m, r);
+    }
+
+    void merge(int l, int m, int r)
+    {
+        std::copy(a + l, a + r + 1, tmp + l);
+        probe.emit(OP_LOAD, l, r);
+        int i = l, j = m + 1, k = l;
+
+        while (i <= m && j <= r) {
+            probe.emit(OP_COMPARE, i, j);
+            a[k] = (tmp[i] <= tmp[j]) ? tmp[i++] : tmp[j++];
+            probe.emit(OP_WRITE, k, a[k]);
+            k++;
+        }
+        while (i <= m) {
+            a[k] = tmp[i++];
+            probe.emit(OP_WRITE, k, a[k]);
+            k++;
+        }
+        while (j <= r) {
+            a[k] = tmp[j++];
+            probe.emit(OP_WRITE, k, a[k]);
+            k++;
+        }
+    }
+};
+
+// ── Parallel Quick Sort (Lomuto, spawns the smaller side) ─────
+template <typename Probe>
+struct ParQuick {
+    WorkPool&  pool;
+    Probe      probe;
+    int*       a;
+    int        cutoff;
+
+    int partition(int l, int r)
+    {
+        int pivot = a[r];
+        int i = l - 1;
+        for (int j = l; j < r; j++) {
+            probe.emit(OP_COMPARE, j, r);
+            if (a[j] <= pivot) {
+                i++;
+                if (i != j) {
+                    std::swap(a[i], a[j]);
+                    probe.emit(OP_SWAP, i, j);
+                }
+            }
+        }
+        int p = i + 1;
+        if (p != r) {
+            std::swap(a[p], a[r]);
+            probe.emit(OP_SWAP, p, r);
+        }
+        probe.emit(OP_SORTED, p, p);
+        return p;
+    }
+
+    // Recurse into (or spawn) the smaller side, loop on the larger one,
+    // so stack depth stays O(log n)
+    void sort(int l, int r)
+    {
+        std::atomic<int> pending{ 0 };
+
+        while (l < r) {
+            int p = partition(l, r);
+            int sl = l, sr = p - 1, bl = p + 1, br = r;
+            if (sr - sl > br - bl) {
+                std::swap(sl, bl);
+                std::swap(sr, br);
+            }
+
+            if (sr - sl + 1 > cutoff)
+                pool.spawn([this, sl, sr] { sort(sl, sr); }, pending);
+            else
+                sort(sl, sr);
+
+            l = bl;
+            r = br;
+        }
+        if (l == r) probe.emit(OP_SORTED, l, l);
+
+        pool.wait(pending);
+    }
+};
+
+template <typename Probe>
+static void runParallelWith(Algorithm algo, int* v, int n, int workers,
+    Probe probe, std::pmr::memory_resource* mr)
+{
+    int cutoff = parCutoff(n, workers);
+    WorkPool pool(workers);
+    std::atomic<int> pending{ 0 };
+    IntBuf tmp(mr);
+
+    if (algo == PARALLEL_MERGE) {
+        tmp.resize(n);
+        ParMerge<Probe> pm{ pool, probe, v, tmp.data(), cutoff };
+        pool.spawn([&pm, n] { pm.sort(0, n - 1); }, pending);
+        pool.wait(pending);
+    }
+    else {
+        ParQuick<Probe> pq{ pool, probe, v, cutoff };
+        pool.spawn([&pq, n] { pq.sort(0, n - 1); }, pending);
+        pool.wait(pending);
+    }
+}
+
+// Sort v on a fresh pool of `workers` threads, tracing into rec if set
+static void runParallel(Algorithm algo, int* v, int n, int workers,
+    LaneTrace* rec,
+    std::pmr::memory_resource* mr = std::pmr::new_delete_resource())
+{
+    if (rec) runParallelWith(algo, v, n, workers, TraceTo{ rec }, mr);
+    else     runParallelWith(algo, v, n, workers, NoTrace{}, mr);
+}
+
+// Untraced wall time on 1 worker divided by wall time on `workers`
+static double measureSpeedup(Algorithm algo, const std::vector<int>& bars,
+    int workers)
+{
+    using Clock = std::chrono::steady_clock;
+    auto timeRun = [&](int w) {
+        std::vector<int> v = bars;
+        auto t0 = Clock::now();
+        runParallel(algo, v.data(), (int)v.size(), w, nullptr);
+        return std::chrono::duration<double>(Clock::now() - t0).count();
+    };
+
+    double t1 = timeRun(1);
+    double tn = timeRun(workers);
+    return tn > 0 ? t1 / tn : 0.0;
+}
+
+struct ParallelEngine : Engine {
+    using Lane = std::pmr::deque<LaneTrace::Stamped>;
+    struct Cursor { Lane::const_iterator at, end; };
+
+    LaneTrace                trace;
+    std::pmr::vector<Cursor> cursor;
+    size_t                   total = 0;
+    size_t                   taken = 0;
+    size_t                   mergeBytes;
+
+    ParallelEngine(Algorithm algo, const std::vector<int>& b, RunArena& arena)
+        : Engine(b, arena.resource()), trace(laneCount(), arena.upstream()),
+          cursor(mem()),
+          mergeBytes(algo == PARALLEL_MERGE ? b.size() * sizeof(int) : 0)
+    {
+        runParallel(algo, a.data(), (int)a.size(), (int)trace.lanes.size(),
+            &trace, mem());
+        for (auto& l : trace.lanes) {
+            total += l.size();
+            cursor.push_back({ l.cbegin(), l.cend() });
+        }
+    }
+
+    // Hand out the lane head with the lowest stamp
+    bool step() override
+    {
+        Cursor* best = nullptr;
+        for (Cursor& c : cursor) {
+            if (c.at == c.end) continue;
+            if (!best || c.at->seq < best->at->seq) best = &c;
+        }
+        if (!best) return false;
+
+        emit((best->at++)->op);
+        taken++;
+        return true;
+    }
+
+    float progress() const override
+    {
+        return total ? (float)taken / total : 1.f;
+    }
+
+    // The real sort's scratch (the merge buffer); the recorded trace is
+    // visualiser overhead and not counted
+    size_t auxBytes() const override { return mergeBytes; }
+};
+
+// ── Dispatcher ─────────────────────
+static std::unique_ptr<Engine> makeEngine(Algorithm algo,
+    const std::vector<int>& bars, const EngineOptions& opts, RunArena& arena)
+{
+    std::pmr::memory_resource* mr = arena.resource();
+    switch (algo) {
+    case BUBBLE:    return std::make_unique<BubbleEngine>(bars, mr);
+    case SELECTION: return std::make_unique<SelectionEngine>(bars, mr);
+    case INSERTION: return std::make_unique<InsertionEngine>(bars, mr);
+    case MERGE:     return std::make_unique<MergeEngine>(bars, mr);
+    case QUICK:     return std::make_unique<QuickEngine>(bars, opts, mr);
+    case HEAP:      return std::make_unique<HeapEngine>(bars, opts.heapArity, mr);
+    case PARALLEL_MERGE:
+    case PARALLEL_QUICK:
+        return std::make_unique<ParallelEngine>(algo, bars, arena);
+    case RADIX:     return std::make_unique<RadixEngine>(bars, mr);
+    case COUNTING:  return std::make_unique<CountingEngine>(bars, mr);
+    case BUCKET:    return std::make_unique<BucketEngine>(bars, mr);
+    case INTRO:     return std::make_unique<IntroEngine>(bars, opts, mr);
+    case TIM:       return std::make_unique<TimEngine>(bars, mr);
+    case EXTERNAL:  return std::make_unique<ExternalEngine>(bars, opts, mr);
+    case BITONIC:   return std::make_unique<BitonicEngine>(bars, mr);
+    default:        return nullptr;
+    }
+}
+
+// Engine for one run, plus the speed-up measurement for parallel ones.
+// The previous run's engine must already be destroyed: the arena is
+// reset here
+static std::unique_ptr<Engine> createEngine(Algorithm algo,
+    const std::vector<int>& bars, const EngineOptions& opts,
+    RunArena& arena, double& speedup, int& workers)
+{
+    arena.reset(RunArena::hintFor(bars.size()));
+    speedup = 0.0;
+    workers = 0;
+    if (isParallel(algo)) {
+        workers = laneCount();
+        speedup = measureSpeedup(algo, bars, workers);
+    }
+    return makeEngine(algo, bars, opts, arena);
+}
+
+// Start a synchronous run (bench).  O(n) for the lazy engines; events
+// come later on demand.
+static void buildSteps(SortState& s)
+{
+    resetRun(s);
+    s.engine.reset();
+    s.engine = createEngine(s.algo, s.bars, s.opts, s.arena,
+        s.speedup, s.workers);
+}
+
+// Replay up to `count` events; returns false once the engine is exhausted
+static bool advance(SortState& s, long long count)
+{
+    Op op{};
+    for (long long k = 0; k < count; k++) {
+        if (!s.engine->next(op)) return false;
+        applyOp(s, op);
+        s.stepIdx++;
+    }
+    s.progress = s.engine->progress();
+    if (s.mem.on) s.mem.noteAux(s.engine->auxBytes());
+    return true;
+}
+
+//  Dry run
+//
+//  The engine driven flat out with nothing replayed: each event is only
+//  counted the way applyOp() would count it.  That gives a run's exact
+//  totals before it starts — the progress bar and ETA use them from the
+//  first frame, and T lays them out for every algorithm at once.  Runs
+//  past TALLY_MAX_EVENTS give up (inputs too big to fit even n log n of
+//  them aren't tried, nor the O(n²) sorts above QUAD_LIMIT), and the
+//  parallel engines, which record their whole trace first, only tally up
+//  to PARALLEL_TRACE_MAX elements.  A dry run on a side thread checks
+//  `stop` as it goes and gives up once it is set.
+
+static const long long TALLY_MAX_EVENTS = 1LL << 26;
+
+static Tally tallyRun(Algorithm algo, const std::vector<int>& bars,
+    const EngineOptions& opts, const std::atomic<bool>* stop = nullptr)
+{
+    Tally t;
+    if ((long long)bars.size() * 16 > TALLY_MAX_EVENTS) return t;
+    if (isParallel(algo) && (int)bars.size() > PARALLEL_TRACE_MAX) return t;
+    if (isQuadratic(algo) && (int)bars.size() > QUAD_LIMIT) return t;
+
+    using Clock = std::chrono::steady_clock;
+    auto t0 = Clock::now();
+    RunArena arena;
+    arena.reset(RunArena::hintFor(bars.size()));
+    std::unique_ptr<Engine> e = makeEngine(algo, bars, opts, arena);
+
+    Op op{};
+    while (e->next(op)) {
+        if (++t.events > TALLY_MAX_EVENTS) return Tally{};
+        if ((t.events & 0xFFFF) == 0 && stop
+            && stop->load(std::memory_order_relaxed))
+            return Tally{};
+        if (op.kind == OP_COMPARE) t.comparisons++;
+        else if (op.kind == OP_SWAP || op.kind == OP_WRITE) t.swaps++;
+    }
+    e.reset();                    // before its arena
+    t.ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    t.valid = true;
+    return t;
+}
+
+//  Native kernels
+//
+//  The same algorithms with no trace, sorting a plain array in place.
+//  --bench times them next to the engines to report raw throughput.
+//  The comparison sorts are templates over the element type and a
+//  strict weak order `less`, so --types can time them on 64-bit keys,
+//  floats and key-value records as well; the counting-based sorts need
+//  integer keys and stay on int.  Each kernel is written once in terms
+//  of less(): `x > y` is less(y, x), `x <= y` is !less(y, x).
+
+// A record sorted by key; value rides along (the stable sorts keep
+// equal keys in input order)
+struct KeyValue {
+    int key;
+    int value;
+};
+
+struct KeyLess {
+    bool operator()(const KeyValue& x, const KeyValue& y) const
+    {
+        return x.key < y.key;
+    }
+};
+
+template <typename T, typename Less>
+static void nativeBubble(T* v, int n, Less less)
+{
+    for (int i = 0; i < n - 1; i++)
+        for (int j = 0; j < n - 1 - i; j++)
+            if (less(v[j + 1], v[j])) std::swap(v[j], v[j + 1]);
+}
+
+template <typename T, typename Less>
+static void nativeSelection(T* v, int n, Less less)
+{
+    for (int i = 0; i < n - 1; i++) {
+        int mi = i;
+        for (int j = i + 1; j < n; j++)
+            if (less(v[j], v[mi])) mi = j;
+        std::swap(v[i], v[mi]);
+    }
+}
+
+template <typename T, typename Less>
+static void insertionSortRange(T* v, int n, Less less)
+{
+    for (int i = 1; i < n; i++) {
+        T   x = v[i];
+        int j = i;
+        for (; j > 0 && less(x, v[j - 1]); j--) v[j] = v[j - 1];
+        v[j] = x;
+    }
+}
+
+// Bottom-up, ping-ponging between v and one scratch buffer
+template <typename T, typename Less>
+static void nativeMerge(T* v, int n, Less less)
+{
+    std::vector<T> tmp(n);
+    T* src = v;
+    T* dst = tmp.data();
+
+    for (int w = 1; w < n; w *= 2) {
+        for (int l = 0; l < n; l += 2 * w) {
+            int m = std::min(l + w, n), r = std::min(l + 2 * w, n);
+            std::merge(src + l, src + m, src + m, src + r, dst + l, less);
+        }
+        std::swap(src, dst);
+    }
+    if (src != v) std::memcpy(v, src, sizeof(T) * n);
+}
+
+template <typename T, typename Less>
+static int medianOf3(const T* v, int x, int y, int z, Less less)
+{
+    if (less(v[y], v[x])) std::swap(x, y);
+    if (!less(v[z], v[y])) return y;
+    return less(v[z], v[x]) ? x : z;
+}
+
+template <typename T, typename Less>
+static int nativePivot(const T* v, int l, int r, PivotRule rule, Less less)
+{
+    int len = r - l + 1;
+    int m = l + len / 2;
+    if (rule == PIVOT_LAST || len < 3) return r;
+    if (rule == PIVOT_MEDIAN3 || len < NINTHER_MIN)
+        return medianOf3(v, l, m, r, less);
+
+    int s = len / 8;
+    return medianOf3(v, medianOf3(v, l, l + s, l + 2 * s, less),
+        medianOf3(v, m - s, m, m + s, less),
+        medianOf3(v, r - 2 * s, r - s, r, less), less);
+}
+
+// Pivot at r.  Returns its final index.
+template <typename T, typename Less>
+static int partitionLomuto(T* v, int l, int r, Less less)
+{
+    T   pivot = v[r];
+    int i = l - 1;
+    for (int j = l; j < r; j++)
+        if (!less(pivot, v[j])) std::swap(v[++i], v[j]);
+    std::swap(v[i + 1], v[r]);
+    return i + 1;
+}
+
+// Pivot at r.  The swap is unconditional and the cursor advances by the
+// comparison result, so the loop has no data-dependent branch.
+template <typename T, typename Less>
+static int partitionBranchless(T* v, int l, int r, Less less)
+{
+    T   pivot = v[r];
+    int i = l;
+    for (int j = l; j < r; j++) {
+        T   x = v[j];
+        int small = !less(pivot, x);
+        v[j] = v[i];
+        v[i] = x;
+        i += small;
+    }
+    std::swap(v[i], v[r]);
+    return i;
+}
+
+// Pivot at l.  Returns the split j: [l, j] <= pivot <= [j + 1, r].
+template <typename T, typename Less>
+static int partitionHoare(T* v, int l, int r, Less less)
+{
+    T   pivot = v[l];
+    int i = l - 1, j = r + 1;
+    for (;;) {
+        do i++; while (less(v[i], pivot));
+        do j--; while (less(pivot, v[j]));
+        if (i >= j) return j;
+        std::swap(v[i], v[j]);
+    }
+}
+
+#if defined(__AVX2__) && !defined(__AVX512F__)
+// Lane permutation that packs the lanes whose bit in m is clear first
+struct PackLut {
+    alignas(32) int idx[256][8];
+
+    PackLut()
+    {
+        for (int m = 0; m < 256; m++) {
+            int k = 0;
+            for (int b = 0; b < 8; b++) if (!(m >> b & 1)) idx[m][k++] = b;
+            for (int b = 0; b < 8; b++) if (m >> b & 1)    idx[m][k++] = b;
+        }
+    }
+};
+static const PackLut PACK_LUT;
+#endif
+
+// Portable: POPCNT is not implied by the AVX2 target flags
+static inline int popCount(unsigned x)
+{
+    x = x - ((x >> 1) & 0x55555555u);
+    x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+    return (int)((((x + (x >> 4)) & 0x0f0f0f0fu) * 0x01010101u) >> 24);
+}
+
+#if defined(__AVX512F__)
+static const char* SIMD_ISA = "AVX-512";
+#elif defined(__AVX2__)
+static const char* SIMD_ISA = "AVX2";
+#else
+static const char* SIMD_ISA = "scalar";
+#endif
+
+// Pivot at r.  Keys <= pivot are packed in place (the write cursor never
+// passes the read cursor), larger keys go to `high`, which needs
+// r - l + 16 slots.  One vector compare per block; returns the pivot's
+// final index.
+static int partitionBlock(int* v, int l, int r, int* high)
+{
+    int pivot = v[r];
+    int lo = l, h = 0, j = l;
+
+#if defined(__AVX512F__)
+    __m512i pv = _mm512_set1_epi32(pivot);
+    for (; j + 16 <= r; j += 16) {
+        __m512i   x = _mm512_loadu_si512(v + j);
+        __mmask16 gt = _mm512_cmpgt_epi32_mask(x, pv);
+        _mm512_mask_compressstoreu_epi32(v + lo, (__mmask16)~gt, x);
+        _mm512_mask_compressstoreu_epi32(high + h, gt, x);
+        int ng = popCount(gt);
+        lo += 16 - ng;
+        h += ng;
+    }
+#elif defined(__AVX2__)
+    __m256i pv = _mm256_set1_epi32(pivot);
+    for (; j + 8 <= r; j += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(v + j));
+        int gt = _mm256_movemask_ps(
+            _mm256_castsi256_ps(_mm256_cmpgt_epi32(x, pv)));
+        __m256i lows = _mm256_permutevar8x32_epi32(x,
+            _mm256_load_si256((const __m256i*)PACK_LUT.idx[gt]));
+        __m256i highs = _mm256_permutevar8x32_epi32(x,
+            _mm256_load_si256((const __m256i*)PACK_LUT.idx[~gt & 0xff]));
+        _mm256_storeu_si256((__m256i*)(v + lo), lows);
+        _mm256_storeu_si256((__m256i*)(high + h), highs);
+        int ng = popCount((unsigned)gt);
+        lo += 8 - ng;
+        h += ng;
+    }
+#endif
+    for (; j < r; j++) {
+        int x = v[j];
+        if (x <= pivot) v[lo++] = x;
+        else            high[h++] = x;
+    }
+
+    v[lo] = pivot;
+    std::memcpy(v + lo + 1, high, sizeof(int) * h);
+    return lo;
+}
+
+// The vector partition compares int lanes with <, so it only stands in
+// for that exact pair; other types take the branchless scheme instead
+template <typename T, typename Less>
+static constexpr bool hasBlockPartition =
+    std::is_same<T, int>::value && std::is_same<Less, std::less<int>>::value;
+
+// Move the chosen pivot home and split [l, r]; [l, loEnd] and
+// [hiStart, r] are left to sort.  `high` is the block scheme's buffer.
+template <typename T, typename Less>
+static void nativePartition(T* a, int l, int r, const EngineOptions& opts,
+    PivotRule rule, T* high, int& loEnd, int& hiStart, Less less)
+{
+    int pi = nativePivot(a, l, r, rule, less);
+    int home = opts.partition == PART_HOARE ? l : r;
+    std::swap(a[pi], a[home]);
+
+    int p;
+    switch (opts.partition) {
+    case PART_HOARE:
+        loEnd = partitionHoare(a, l, r, less);
+        hiStart = loEnd + 1;
+        return;
+    case PART_BLOCK:
+        if constexpr (hasBlockPartition<T, Less>) {
+            p = partitionBlock(a, l, r, high);
+            break;
+        }
+        else (void)high;
+        [[fallthrough]];
+    case PART_BRANCHLESS: p = partitionBranchless(a, l, r, less); break;
+    default:              p = partitionLomuto(a, l, r, less);     break;
+    }
+    loEnd = p - 1;
+    hiStart = p + 1;
+}
+
+// Iterative, recursing into the smaller side only.  Pivot rule and
+// partition scheme as in QuickEngine.
+template <typename T, typename Less>
+static void nativeQuick(T* a, int n, const EngineOptions& opts, Less less)
+{
+    struct Range { int l, r; };
+    std::vector<Range> work = { { 0, n - 1 } };
+    std::vector<T>     high;
+    if (opts.partition == PART_BLOCK) high.resize(n + 16);
+
+    while (!work.empty()) {
+        Range wr = work.back();
+        work.pop_back();
+        int l = wr.l, r = wr.r;
+
+        while (l < r) {
+            int loEnd, hiStart;
+            nativePartition(a, l, r, opts, opts.pivot, high.data(),
+                loEnd, hiStart, less);
+
+            if (loEnd - l < r - hiStart) { work.push_back({ hiStart, r }); r = loEnd; }
+            else                         { work.push_back({ l, loEnd });   l = hiStart; }
+        }
+    }
+}
+
+// d-ary max-heap; the sift-down is a loop, one level per iteration
+template <typename T, typename Less>
+static void heapSortRange(T* v, int n, int d, Less less)
+{
+    auto sift = [v, d, less](int node, int end) {
+        for (;;) {
+            int lg = node, first = d * node + 1;
+            int last = std::min(first + d, end);
+            for (int c = first; c < last; c++)
+                if (less(v[lg], v[c])) lg = c;
+            if (lg == node) return;
+            std::swap(v[node], v[lg]);
+            node = lg;
+        }
+    };
+    for (int i = n > 1 ? (n - 2) / d : -1; i >= 0; i--) sift(i, n);
+    for (int end = n - 1; end > 0; end--) {
+        std::swap(v[0], v[end]);
+        sift(0, end);
+    }
+}
+
+// Same decisions as IntroEngine: insertion sort at or below the cutoff,
+// heap sort past the depth limit, partition otherwise.
+template <typename T, typename Less>
+static void nativeIntro(T* a, int n, const EngineOptions& opts, Less less)
+{
+    struct Range { int l, r, depth; };
+    int lg = 0;
+    while ((1 << (lg + 1)) <= std::max(1, n)) lg++;
+    int limit = opts.introDepth * lg;
+    PivotRule rule = opts.pivot == PIVOT_LAST ? PIVOT_MEDIAN3 : opts.pivot;
+
+    std::vector<Range> work = { { 0, n - 1, 0 } };
+    std::vector<T>     high;
+    if (opts.partition == PART_BLOCK) high.resize(n + 16);
+
+    while (!work.empty()) {
+        Range wr = work.back();
+        work.pop_back();
+        int len = wr.r - wr.l + 1;
+
+        if (len <= 1) continue;
+        if (len <= opts.introCutoff) {
+            insertionSortRange(a + wr.l, len, less);
+        }
+        else if (wr.depth >= limit) {
+            heapSortRange(a + wr.l, len, opts.heapArity, less);
+        }
+        else {
+            int loEnd, hiStart;
+            nativePartition(a, wr.l, wr.r, opts, rule, high.data(),
+                loEnd, hiStart, less);
+            work.push_back({ wr.l,    loEnd, wr.depth + 1 });
+            work.push_back({ hiStart, wr.r,  wr.depth + 1 });
+        }
+    }
+}
+
+// LSD radix.  One read fills every pass's histogram.  The scatter goes
+// through a one-cache-line staging buffer per bucket that is flushed
+// whole (software write-combining), so the 2^bits live output streams
+// cost one hot line each instead of a cold store per key.  A pass whose
+// digit is the same for every key is skipped.
+static void nativeRadix(std::vector<int>& v)
+{
+    int n = (int)v.size();
+    if (n < 2) return;
+
+    int passes;
+    int bits = radixBits(*std::max_element(v.begin(), v.end()), passes);
+    int nb = 1 << bits, mask = nb - 1;
+
+    std::vector<int> hist((size_t)passes * nb, 0);
+    for (int x : v)
+        for (int p = 0; p < passes; p++)
+            hist[(size_t)p * nb + ((x >> (p * bits)) & mask)]++;
+
+    const int LINE = 64 / sizeof(int);
+    std::vector<int> tmp(n);
+    std::vector<int> wcMem((size_t)nb * LINE + LINE);
+    int* wc = (int*)(((uintptr_t)wcMem.data() + 63) & ~(uintptr_t)63);
+    std::vector<unsigned char> used(nb);
+
+    int* src = v.data();
+    int* dst = tmp.data();
+    for (int p = 0; p < passes; p++) {
+        int* h = &hist[(size_t)p * nb];
+        int  shift = p * bits;
+        if (h[(src[0] >> shift) & mask] == n) continue;
+
+        for (int d = 0, sum = 0; d < nb; d++) {
+            int c = h[d];
+            h[d] = sum;
+            sum += c;
+        }
+
+        std::fill(used.begin(), used.end(), 0);
+        for (int i = 0; i < n; i++) {
+            int  x = src[i];
+            int  d = (x >> shift) & mask;
+            int* line = wc + (size_t)d * LINE;
+            line[used[d]++] = x;
+            if (used[d] == LINE) {
+                std::memcpy(dst + h[d], line, sizeof(int) * LINE);
+                h[d] += LINE;
+                used[d] = 0;
+            }
+        }
+        for (int d = 0; d < nb; d++)
+            if (used[d])
+                std::memcpy(dst + h[d], wc + (size_t)d * LINE,
+                    sizeof(int) * used[d]);
+        std::swap(src, dst);
+    }
+    if (src != v.data()) std::memcpy(v.data(), src, sizeof(int) * n);
+}
+
+static void nativeCounting(std::vector<int>& v)
+{
+    if (v.empty()) return;
+    auto mm = std::minmax_element(v.begin(), v.end());
+    int  lo = *mm.first;
+    std::vector<int> count((size_t)(*mm.second - lo) + 1, 0);
+
+    for (int x : v) count[x - lo]++;
+    int* out = v.data();
+    for (size_t k = 0; k < count.size(); k++)
+        for (int c = count[k]; c > 0; c--) *out++ = (int)k + lo;
+}
+
+// Bucket sizes from one read, a scatter into place, then insertion sort
+// per bucket.  Same bucket count as BucketEngine.
+static void nativeBucket(std::vector<int>& v)
+{
+    int n = (int)v.size();
+    if (n < 2) return;
+    auto mm = std::minmax_element(v.begin(), v.end());
+    int       lo = *mm.first;
+    long long span = (long long)*mm.second - lo + 1;
+    int       nb = std::max(1, n / 8);
+
+    std::vector<int> start(nb + 1, 0);
+    for (int x : v) start[bucketOf(x, lo, span, nb) + 1]++;
+    std::partial_sum(start.begin(), start.end(), start.begin());
+
+    std::vector<int> fill(start.begin(), start.end() - 1);
+    std::vector<int> src = v;
+    for (int x : src) v[fill[bucketOf(x, lo, span, nb)]++] = x;
+
+    for (int b = 0; b < nb; b++)
+        for (int i = start[b] + 1; i < start[b + 1]; i++) {
+            int x = v[i], j = i;
+            for (; j > start[b] && v[j - 1] > x; j--) v[j] = v[j - 1];
+            v[j] = x;
+        }
+}
+
+// TimSort, the same policy as TimEngine: natural runs, binary insertion
+// up to minRun, stack merges with pre-trimming and galloping
+template <typename T, typename Less>
+static int gallopNative(const T* v, int len, const T& key, bool left,
+    bool fromEnd, Less less)
+{
+    int lo = 0, hi = len, ofs = 1;
+    bool expo = true;
+    while (lo < hi) {
+        int p = !expo ? lo + (hi - lo) / 2
+            : fromEnd ? std::max(lo, hi - ofs)
+            : std::min(hi - 1, lo + ofs - 1);
+        bool before = left ? less(v[p], key) : !less(key, v[p]);
+        if (before) lo = p + 1;
+        else        hi = p;
+        if (before == fromEnd) expo = false;
+        else ofs *= 2;
+    }
+    return lo;
+}
+
+template <typename T, typename Less>
+struct TimNative {
+    T*   a;
+    Less less;
+    std::vector<T> tmp;
+    int minGallop = TIM_MIN_GALLOP;
+
+    // A = [baseA, baseA + lenA) in tmp, merged forwards into baseA
+    void mergeLo(int baseA, int lenA, int baseB, int lenB)
+    {
+        tmp.assign(a + baseA, a + baseA + lenA);
+        T* t = tmp.data();
+        int pa = 0, pb = baseB, endB = baseB + lenB, dest = baseA;
+
+        while (pa < lenA && pb < endB) {
+            int winA = 0, winB = 0;
+            while (pa < lenA && pb < endB
+                && winA < minGallop && winB < minGallop) {
+                if (less(a[pb], t[pa])) { a[dest++] = a[pb++]; winB++; winA = 0; }
+                else               { a[dest++] = t[pa++]; winA++; winB = 0; }
+            }
+            while (pa < lenA && pb < endB) {
+                minGallop -= minGallop > 1;
+                winA = gallopNative(t + pa, lenA - pa, a[pb], false, false,
+                    less);
+                std::memcpy(a + dest, t + pa, sizeof(T) * winA);
+                dest += winA; pa += winA;
+                if (pa == lenA) break;
+                a[dest++] = a[pb++];
+                if (pb == endB) break;
+
+                winB = gallopNative(a + pb, endB - pb, t[pa], true, false,
+                    less);
+                std::memmove(a + dest, a + pb, sizeof(T) * winB);
+                dest += winB; pb += winB;
+                if (pb == endB) break;
+                a[dest++] = t[pa++];
+                if (winA < TIM_MIN_GALLOP && winB < TIM_MIN_GALLOP) {
+                    minGallop++;
+                    break;
+                }
+            }
+        }
+        std::memcpy(a + dest, t + pa, sizeof(T) * (lenA - pa));
+    }
+
+    // B in tmp, merged backwards into the end of B
+    void mergeHi(int baseA, int lenA, int baseB, int lenB)
+    {
+        tmp.assign(a + baseB, a + baseB + lenB);
+        T* t = tmp.data();
+        int pa = baseA + lenA - 1, pb = lenB - 1, dest = baseB + lenB - 1;
+
+        while (pa >= baseA && pb >= 0) {
+            int winA = 0, winB = 0;
+            while (pa >= baseA && pb >= 0
+                && winA < minGallop && winB < minGallop) {
+                if (less(t[pb], a[pa])) { a[dest--] = a[pa--]; winA++; winB = 0; }
+                else               { a[dest--] = t[pb--]; winB++; winA = 0; }
+            }
+            while (pa >= baseA && pb >= 0) {
+                minGallop -= minGallop > 1;
+                int remA = pa - baseA + 1;
+                winA = remA - gallopNative(a + baseA, remA, t[pb], false, true,
+                    less);
+                dest -= winA; pa -= winA;
+                std::memmove(a + dest + 1, a + pa + 1, sizeof(T) * winA);
+                if (pa < baseA) break;
+                a[dest--] = t[pb--];
+                if (pb < 0) break;
+
+                winB = pb + 1 - gallopNative(t, pb + 1, a[pa], true, true,
+                    less);
+                dest -= winB; pb -= winB;
+                std::memcpy(a + dest + 1, t + pb + 1, sizeof(T) * winB);
+                if (pb < 0) break;
+                a[dest--] = a[pa--];
+                if (winA < TIM_MIN_GALLOP && winB < TIM_MIN_GALLOP) {
+                    minGallop++;
+                    break;
+                }
+            }
+        }
+        std::memcpy(a + dest - pb, t, sizeof(T) * (pb + 1));
+    }
+
+    void mergeAt(std::vector<std::pair<int, int>>& runs, int k)
+    {
+        int baseA = runs[k].first,     lenA = runs[k].second;
+        int baseB = runs[k + 1].first, lenB = runs[k + 1].second;
+        runs[k].second += lenB;
+        runs.erase(runs.begin() + k + 1);
+
+        int skip = gallopNative(a + baseA, lenA, a[baseB], false, false,
+            less);
+        baseA += skip;
+        lenA -= skip;
+        if (lenA == 0) return;
+        lenB = gallopNative(a + baseB, lenB, a[baseA + lenA - 1], true, true,
+            less);
+        if (lenB == 0) return;
+
+        if (lenA <= lenB) mergeLo(baseA, lenA, baseB, lenB);
+        else              mergeHi(baseA, lenA, baseB, lenB);
+    }
+};
+
+template <typename T, typename Less>
+static void nativeTim(T* a, int n, Less less)
+{
+    int minRun = timMinRun(n);
+    TimNative<T, Less> tn{ a, less, {} };
+    std::vector<std::pair<int, int>> runs;   // base, length
+
+    for (int lo = 0; lo < n; ) {
+        int hi = lo + 1;
+        if (hi < n) {
+            if (less(a[hi++], a[lo])) {
+                while (hi < n && less(a[hi], a[hi - 1])) hi++;
+                std::reverse(a + lo, a + hi);
+            }
+            else while (hi < n && !less(a[hi], a[hi - 1])) hi++;
+        }
+
+        // Binary insertion up to minRun
+        for (int end = std::min(n, lo + minRun); hi < end; hi++) {
+            T   x = a[hi];
+            int at = (int)(std::upper_bound(a + lo, a + hi, x, less) - a);
+            std::memmove(a + at + 1, a + at, sizeof(T) * (hi - at));
+            a[at] = x;
+        }
+        runs.push_back({ lo, hi - lo });
+        lo = hi;
+
+        for (;;) {
+            int k = (int)runs.size() - 2;
+            auto L = [&runs](int i) { return runs[i].second; };
+            if (k < 0) break;
+            if ((k > 0 && L(k - 1) <= L(k) + L(k + 1))
+                || (k > 1 && L(k - 2) <= L(k - 1) + L(k)))
+                tn.mergeAt(runs, L(k - 1) < L(k + 1) ? k - 1 : k);
+            else if (L(k) <= L(k + 1))
+                tn.mergeAt(runs, k);
+            else break;
+        }
+    }
+
+    while (runs.size() > 1) {
+        int k = (int)runs.size() - 2;
+        if (k > 0 && runs[k - 1].second < runs[k + 1].second) k--;
+        tn.mergeAt(runs, k);
+    }
+}
+
+// External merge sort through real temporary files.  Each run is sorted
+// in memory and spilled to one spill file per pass (std::tmpfile, gone
+// on close); a pass merges extFanIn runs at a time through a loser tree,
+// every run read through its own EXT_IO_KEYS-key buffer and the output
+// written in blocks of the same size.  The last pass writes straight
+// back into the array.  io, if given, gets the traffic and the time
+// spent inside fread / fwrite.
+struct IoStats {
+    long long bytesRead = 0, bytesWritten = 0;
+    int       runs = 0, passes = 0;
+    double    ioSec = 0.0;
+};
+
+static const int EXT_IO_KEYS = 1 << 14;   // buffer per stream
+
+template <typename T>
+struct SpillFile {
+    FILE*    f = nullptr;
+    IoStats& io;
+
+    explicit SpillFile(IoStats& s) : f(std::tmpfile()), io(s) {}
+    ~SpillFile() { if (f) std::fclose(f); }
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    void write(long long at, const T* p, size_t cnt)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        std::fseek(f, (long)(at * (long long)sizeof(T)), SEEK_SET);
+        std::fwrite(p, sizeof(T), cnt, f);
+        io.ioSec += std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - t0).count();
+        io.bytesWritten += (long long)(cnt * sizeof(T));
+    }
+
+    size_t read(long long at, T* p, size_t cnt)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        std::fseek(f, (long)(at * (long long)sizeof(T)), SEEK_SET);
+        size_t got = std::fread(p, sizeof(T), cnt, f);
+        io.ioSec += std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - t0).count();
+        io.bytesRead += (long long)(got * sizeof(T));
+        return got;
+    }
+};
+
+template <typename T, typename Less>
+static void nativeExternal(T* v, int n, const EngineOptions& opts, Less less,
+    IoStats* stats)
+{
+    IoStats local;
+    IoStats& io = stats ? *stats : local;
+    int runLen = extRunLen(opts, n);
+    int fanIn = std::max(2, std::min(EXT_FANIN_MAX, opts.extFanIn));
+
+    auto sortRun = [&](T* p, int len) {
+        if (opts.extRunQuick) nativeQuick(p, len, opts, less);
+        else                  nativeMerge(p, len, less);
+    };
+    if (n <= runLen) { io.runs = 1; sortRun(v, n); return; }
+
+    // Run formation, spilled to the first file
+    struct Run { long long base; int len; };
+    std::vector<Run> runs;
+    auto in = std::make_unique<SpillFile<T>>(io);
+    if (!in->f) { sortRun(v, n); return; }         // no temp directory
+    std::vector<T> buf(runLen);
+    for (int base = 0; base < n; base += runLen) {
+        int len = std::min(runLen, n - base);
+        std::memcpy(buf.data(), v + base, sizeof(T) * len);
+        sortRun(buf.data(), len);
+        in->write(base, buf.data(), len);
+        runs.push_back({ base, len });
+    }
+    io.runs = (int)runs.size();
+
+    struct Reader {
+        long long at, left;
+        std::vector<T> buf;
+        size_t pos = 0, got = 0;
+    };
+    std::vector<Reader> rd(fanIn);
+    std::vector<T>      wbuf(EXT_IO_KEYS);
+    int loser[EXT_FANIN_MAX];
+
+    while (runs.size() > 1) {
+        bool last = (int)runs.size() <= fanIn;
+        std::unique_ptr<SpillFile<T>> outFile;
+        if (!last) {
+            outFile = std::make_unique<SpillFile<T>>(io);
+            if (!outFile->f) { sortRun(v, n); return; }
+        }
+        std::vector<Run> next;
+        io.passes++;
+
+        for (size_t g0 = 0; g0 < runs.size(); g0 += fanIn) {
+            int k = (int)std::min<size_t>(fanIn, runs.size() - g0);
+            long long outAt = runs[g0].base, total = 0;
+            for (int i = 0; i < k; i++) {
+                Reader& r = rd[i];
+                r.at = runs[g0 + i].base;
+                r.left = runs[g0 + i].len;
+                r.buf.resize(EXT_IO_KEYS);
+                r.pos = r.got = 0;
+                total += r.left;
+            }
+
+            // The head of run i, refilled from the file as it drains
+            auto live = [&](int i) {
+                if (i >= k) return false;
+                Reader& r = rd[i];
+                if (r.pos < r.got) return true;
+                if (r.left == 0) return false;
+                size_t want = (size_t)std::min<long long>(EXT_IO_KEYS, r.left);
+                r.got = in->read(r.at, r.buf.data(), want);
+                r.at += (long long)r.got;
+                r.left -= (long long)r.got;
+                r.pos = 0;
+                if (r.got < want) r.left = 0;     // short file: stop
+                return r.got > 0;
+            };
+            auto beats = [&](int y, int x) {      // y wins over x
+                if (!live(y)) return false;
+                if (!live(x)) return true;
+                const T& vy = rd[y].buf[rd[y].pos];
+                const T& vx = rd[x].buf[rd[x].pos];
+                return less(vy, vx) || (!less(vx, vy) && y < x);
+            };
+
+            int K = 1;
+            while (K < k) K *= 2;
+            int win[2 * EXT_FANIN_MAX];
+            for (int i = 0; i < K; i++) win[K + i] = i;
+            for (int node = K - 1; node >= 1; node--) {
+                int x = win[2 * node], y = win[2 * node + 1];
+                bool yWins = beats(y, x);
+                win[node] = yWins ? y : x;
+                loser[node] = yWins ? x : y;
+            }
+            int champ = win[1];
+
+            int wn = 0;
+            long long written = 0;
+            auto flush = [&]() {
+                if (last) std::memcpy(v + outAt + written, wbuf.data(),
+                    sizeof(T) * wn);
+                else outFile->write(outAt + written, wbuf.data(), wn);
+                written += wn;
+                wn = 0;
+            };
+            while (live(champ)) {
+                Reader& r = rd[champ];
+                wbuf[wn++] = r.buf[r.pos++];
+                if (wn == EXT_IO_KEYS) flush();
+                for (int node = (champ + K) / 2; node >= 1; node /= 2)
+                    if (beats(loser[node], champ)) std::swap(champ, loser[node]);
+            }
+            flush();
+            next.push_back({ runs[g0].base, (int)total });
+        }
+        runs.swap(next);
+        if (!last) in = std::move(outFile);
+    }
+}
+
+// The engine's network, walked a 2j-block at a time so each pass is
+// a straight loop over the pairs with a partner below n.  The compare-
+// exchange is branchless: its outcome is a coin toss on random input.
+template <typename T, typename Less>
+static void nativeBitonic(T* a, int n, Less less)
+{
+    int K = 1;
+    while (K < n) K <<= 1;
+    for (int k = 2; k <= K; k *= 2)
+        for (int j = k / 2; j >= 1; j /= 2)
+            for (int b = 0; b < n; b += 2 * j) {
+                bool mirror = j == k / 2;
+                T*   x = a + b;
+                int  o0 = mirror ? std::max(0, b + 2 * j - n) : 0;
+                int  o1 = mirror ? j : std::min(j, n - b - j);
+                for (int o = o0; o < o1; o++) {
+                    T& u = x[o];
+                    T& w = mirror ? x[2 * j - 1 - o] : x[o + j];
+                    bool sw = less(w, u);
+                    T lo = sw ? w : u, hi = sw ? u : w;
+                    u = lo;
+                    w = hi;
+                }
+            }
+}
+
+// The comparison sorts on any trivially copyable T.  Returns false for
+// the algorithms that need integer keys (radix, counting, bucket) and
+// so have no kernel here.  The parallel kernels run through
+// runParallel, which is int-only, so they report false for other types.
+// io collects External Sort's file traffic
+template <typename T, typename Less>
+static bool nativeSortAs(Algorithm algo, T* a, int n,
+    const EngineOptions& opts, Less less, IoStats* io = nullptr)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+        "native kernels move elements with memcpy");
+    switch (algo) {
+    case BUBBLE:    nativeBubble(a, n, less);    break;
+    case SELECTION: nativeSelection(a, n, less); break;
+    case INSERTION: insertionSortRange(a, n, less); break;
+    case MERGE:     nativeMerge(a, n, less);     break;
+    case QUICK:     nativeQuick(a, n, opts, less); break;
+    case HEAP:      heapSortRange(a, n, opts.heapArity, less); break;
+    case INTRO:     nativeIntro(a, n, opts, less); break;
+    case TIM:       nativeTim(a, n, less);       break;
+    case EXTERNAL:  nativeExternal(a, n, opts, less, io); break;
+    case BITONIC:   nativeBitonic(a, n, less);   break;
+    default:        return false;
+    }
+    return true;
+}
+
+static void nativeSort(Algorithm algo, std::vector<int>& v,
+    const EngineOptions& opts, IoStats* io = nullptr)
+{
+    switch (algo) {
+    case PARALLEL_MERGE:
+    case PARALLEL_QUICK:
+        runParallel(algo, v.data(), (int)v.size(), laneCount(), nullptr);
+        break;
+    case RADIX:     nativeRadix(v);     break;
+    case COUNTING:  nativeCounting(v);  break;
+    case BUCKET:    nativeBucket(v);    break;
+    default:
+        nativeSortAs(algo, v.data(), (int)v.size(), opts, std::less<int>(), io);
+        break;
+    }
+}
+
+//  Hardware counters  (N — run native)
+//
+//  Runs the selected algorithm's native kernel on a copy of the bars on a
+//  side thread and reads the CPU's performance counters around it.  Linux
+//  uses perf_event_open (user space only, inherited by the parallel
+//  kernels' pool threads); counters the kernel or platform refuses — and
+//  every counter off Linux — are reported as n/a.
+
+enum HwCounter { HW_CYCLES = 0, HW_INSTR, HW_BRANCH_MISS, HW_L1D_MISS,
+    HW_LLC_MISS, HW_COUNT };
+
+static const char* HW_NAMES[HW_COUNT] = {
+    "Cycles", "Instructions", "Branch miss", "L1D miss", "LLC miss"
+};
+
+struct HwSample {
+    Algorithm algo = BUBBLE;
+    int       n = 0;
+    double    ms = 0.0;
+    bool      sorted = false;
+    bool      skipped = false;    // O(n²) run above QUAD_LIMIT
+    long long value[HW_COUNT] = {};
+    bool      valid[HW_COUNT] = {};
+};
+
+#if defined(__linux__)
+class PerfCounters {
+public:
+    PerfCounters()
+    {
+        const unsigned long long cacheL1dReadMiss =
+            PERF_COUNT_HW_CACHE_L1D
+            | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        const struct { unsigned type; unsigned long long config; } spec[HW_COUNT] = {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            { PERF_TYPE_HW_CACHE, cacheL1dReadMiss },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        };
+
+        for (int c = 0; c < HW_COUNT; c++) {
+            perf_event_attr pe;
+            std::memset(&pe, 0, sizeof(pe));
+            pe.size = sizeof(pe);
+            pe.type = spec[c].type;
+            pe.config = spec[c].config;
+            pe.disabled = 1;
+            pe.inherit = 1;
+            pe.exclude_kernel = 1;
+            pe.exclude_hv = 1;
+            fd[c] = (int)syscall(SYS_perf_event_open, &pe, 0, -1, -1, 0);
+        }
+    }
+
+    ~PerfCounters()
+    {
+        for (int f : fd) if (f >= 0) close(f);
+    }
+
+    void start()
+    {
+        for (int f : fd) {
+            if (f < 0) continue;
+            ioctl(f, PERF_EVENT_IOC_RESET, 0);
+            ioctl(f, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    void stop(HwSample& out)
+    {
+        for (int c = 0; c < HW_COUNT; c++) {
+            if (fd[c] < 0) continue;
+            ioctl(fd[c], PERF_EVENT_IOC_DISABLE, 0);
+            long long v = 0;
+            out.valid[c] = read(fd[c], &v, sizeof(v)) == (ssize_t)sizeof(v);
+            out.value[c] = v;
+        }
+    }
+
+private:
+    int fd[HW_COUNT];
+};
+#else
+class PerfCounters {
+public:
+    void start() {}
+    void stop(HwSample&) {}
+};
+#endif
+
+// Time one native run under the counters (any thread)
+static HwSample measureNative(Algorithm algo, std::vector<int> v,
+    const EngineOptions& opts, InputPattern pat)
+{
+    HwSample r;
+    r.algo = algo;
+    r.n = (int)v.size();
+    if ((isQuadratic(algo) || degradesOn(algo, opts, pat)) && r.n > QUAD_LIMIT) {
+        r.skipped = true;
+        return r;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    PerfCounters pc;
+    auto t0 = Clock::now();
+    pc.start();
+    nativeSort(algo, v, opts);
+    pc.stop(r);
+    r.ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    r.sorted = std::is_sorted(v.begin(), v.end());
+    return r;
+}
+
+// Owns the side thread for the window's "run native" key
+class NativeRunner {
+public:
+    ~NativeRunner() { if (thread.joinable()) thread.join(); }
+
+    bool busy() const { return running.load(std::memory_order_acquire); }
+    bool hasResult() const { return have && !busy(); }
+    const HwSample& result() const { return sample; }
+
+    // Ignored while a run is in flight
+    void start(Algorithm algo, const std::vector<int>& bars,
+        const EngineOptions& opts, InputPattern pat)
+    {
+        if (busy()) return;
+        if (thread.joinable()) thread.join();
+        running.store(true, std::memory_order_release);
+        have = true;
+        thread = std::thread([this, algo, bars, opts, pat]() mutable {
+            sample = measureNative(algo, std::move(bars), opts, pat);
+            running.store(false, std::memory_order_release);
+        });
+    }
+
+private:
+    std::thread       thread;
+    std::atomic<bool> running{ false };
+    bool              have = false;
+    HwSample          sample;
+};
+
+// Owns the side thread for the window's comparison table (T): a dry run
+// of every algorithm on the current input, rows filled in as they finish
+class TallyTable {
+public:
+    ~TallyTable() { cancel(); }
+
+    bool shown = false;
+
+    // Rows [0, ready()) are final
+    int ready() const { return done.load(std::memory_order_acquire); }
+    bool busy() const { return count >= 0 && ready() < ALGO_COUNT; }
+    const Tally& row(int a) const { return rows[a]; }
+    int n() const { return count; }
+
+    // The table was made for this input and these options
+    bool matches(const InputSpec& in, int n, const EngineOptions& o) const
+    {
+        return count == n && input.pattern == in.pattern
+            && input.seed == in.seed && input.swaps == in.swaps
+            && opts.heapArity == o.heapArity && opts.pivot == o.pivot
+            && opts.partition == o.partition
+            && opts.introCutoff == o.introCutoff
+            && opts.introDepth == o.introDepth
+            && opts.extRunSize == o.extRunSize
+            && opts.extFanIn == o.extFanIn
+            && opts.extRunQuick == o.extRunQuick;
+    }
+
+    void start(const std::vector<int>& bars, const InputSpec& in,
+        const EngineOptions& o)
+    {
+        cancel();
+        input = in;
+        opts = o;
+        count = (int)bars.size();
+        done.store(0, std::memory_order_relaxed);
+        stop.store(false, std::memory_order_relaxed);
+        thread = std::thread([this, bars] {
+            for (int a = 0; a < ALGO_COUNT; a++) {
+                if (stop.load(std::memory_order_relaxed)) return;
+                rows[a] = tallyRun((Algorithm)a, bars, opts, &stop);
+                done.store(a + 1, std::memory_order_release);
+            }
+        });
+    }
+
+private:
+    std::thread       thread;
+    std::atomic<bool> stop{ false };
+    std::atomic<int>  done{ 0 };
+    Tally             rows[ALGO_COUNT];
+    InputSpec         input;
+    EngineOptions     opts;
+    int               count = -1;
+
+    void cancel()
+    {
+        stop.store(true, std::memory_order_relaxed);
+        if (thread.joinable()) thread.join();
+    }
+};
+
+//  Background sort worker
+//
+//  In the window the engine runs on its own thread and feeds a bounded
+//  single-producer / single-consumer ring; the render thread drains up to
+//  a time budget per frame.  Control flows the other way through a small
+//  command ring, so starting, pausing and switching runs never block the
+//  render thread — engine construction (including the parallel engines'
+//  recording) happens on the worker too.  Every event is tagged with the
+//  run's epoch so anything still queued from an abandoned run is dropped.
+
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacityPow2)
+        : buf(capacityPow2), mask(capacityPow2 - 1) {}
+
+    bool push(const T& v)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) > mask) return false;
+        buf[t & mask] = v;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& v)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        v = buf[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> buf;
+    size_t         mask;
+    alignas(64) std::atomic<size_t> head{ 0 };
+    alignas(64) std::atomic<size_t> tail{ 0 };
+};
+
+// One queued event; `last` marks the end of a run
+struct Event {
+    Op       op;
+    float    progress;
+    unsigned epoch;
+    bool     last;
+};
+
+enum CmdKind : unsigned char { CMD_LOAD, CMD_RUN, CMD_PAUSE, CMD_DROP, CMD_QUIT };
+
+struct Cmd {
+    CmdKind           kind;
+    Algorithm         algo;
+    unsigned          epoch;
+    std::vector<int>* bars;       // CMD_LOAD: worker takes ownership
+    EngineOptions     opts;
+    bool              tally;      // CMD_LOAD: dry-run the totals first
+};
+
+class SortWorker {
+public:
+    SpscRing<Event> events{ 1 << 16 };
+
+    // Published once a CMD_LOAD has built its engine
+    std::atomic<unsigned> readyEpoch{ 0 };
+    double                speedup = 0.0;
+    int                   workers = 0;
+
+    // Published once that load's dry run, if it asked for one, is done
+    std::atomic<unsigned> tallyEpoch{ 0 };
+    Tally                 tally;
+
+    std::atomic<size_t>   auxBytes{ 0 };   // engine scratch, per batch
+    std::atomic<size_t>   arenaBytes{ 0 }; // run arena totals, per batch
+    std::atomic<long long> arenaAllocs{ 0 };
+
+    SortWorker() : thread([this] { loop(); }) {}
+
+    ~SortWorker()
+    {
+        send({ CMD_QUIT, BUBBLE, 0, nullptr, {}, false });
+        thread.join();
+    }
+
+    // Begin a new run of algo on a copy of bars; returns its epoch.
+    // With `withTally` the run's totals are dry-run on a side thread
+    // while the engine is built and starts replaying.
+    unsigned load(Algorithm algo, const std::vector<int>& bars,
+        const EngineOptions& opts, bool withTally = false)
+    {
+        send({ CMD_LOAD, algo, ++epoch, new std::vector<int>(bars), opts,
+            withTally });
+        return epoch;
+    }
+
+    // Abandon the current run; returns the new (empty) epoch
+    unsigned drop()
+    {
+        send({ CMD_DROP, BUBBLE, ++epoch, nullptr, {}, false });
+        return epoch;
+    }
+
+    void setRunning(bool on)
+    {
+        send({ on ? CMD_RUN : CMD_PAUSE, BUBBLE, 0, nullptr, {}, false });
+    }
+
+private:
+    SpscRing<Cmd> cmds{ 64 };
+    unsigned      epoch = 0;      // owned by the render thread
+    std::thread   thread;
+
+    // The dry run's thread; started and joined by the worker only
+    std::thread       tallyThread;
+    std::atomic<bool> tallyStop{ false };
+
+    void stopTally()
+    {
+        tallyStop.store(true, std::memory_order_relaxed);
+        if (tallyThread.joinable()) tallyThread.join();
+        tallyStop.store(false, std::memory_order_relaxed);
+    }
+
+    void startTally(const Cmd& c)
+    {
+        tallyThread = std::thread([this, algo = c.algo, bars = *c.bars,
+            opts = c.opts, e = c.epoch] {
+            Tally t = tallyRun(algo, bars, opts, &tallyStop);
+            if (tallyStop.load(std::memory_order_relaxed)) return;
+            tally = t;
+            tallyEpoch.store(e, std::memory_order_release);
+        });
+    }
+
+    void send(const Cmd& c)
+    {
+        while (!cmds.push(c)) std::this_thread::yield();
+    }
+
+    void publishArena(const RunArena& arena)
+    {
+        arenaBytes.store(arena.bytes(), std::memory_order_relaxed);
+        arenaAllocs.store(arena.allocs(), std::memory_order_relaxed);
+    }
+
+    void loop()
+    {
+        RunArena arena;                       // declared first: outlives engine
+        std::unique_ptr<Engine> engine;
+        unsigned runEpoch = 0;
+        bool     running = false;
+        bool     done = true;
+        bool     held = false;      // `pending` could not be pushed yet
+        Event    pending = {};
+
+        for (;;) {
+            Cmd c;
+            while (cmds.pop(c)) {
+                switch (c.kind) {
+                case CMD_LOAD:
+                    engine.reset();
+                    stopTally();
+                    if (c.tally) startTally(c);
+                    engine = createEngine(c.algo, *c.bars, c.opts, arena,
+                        speedup, workers);
+                    delete c.bars;
+                    publishArena(arena);
+                    runEpoch = c.epoch;
+                    done = held = false;
+                    readyEpoch.store(c.epoch, std::memory_order_release);
+                    break;
+                case CMD_RUN:   running = true;  break;
+                case CMD_PAUSE: running = false; break;
+                case CMD_DROP:
+                    engine.reset();
+                    stopTally();
+                    arena.reset(0);
+                    runEpoch = c.epoch;
+                    done = true;
+                    break;
+                case CMD_QUIT:
+                    stopTally();
+                    return;
+                }
+            }
+
+            if (!engine || !running || done) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            // Top up the ring; back off briefly once it is full
+            bool full = false;
+            for (int k = 0; k < 4096 && !done; k++) {
+                if (!held) {
+                    Op op{};
+                    bool more = engine->next(op);
+                    pending = { op, more ? engine->progress() : 1.f,
+                        runEpoch, !more };
+                    held = true;
+                }
+                if (!events.push(pending)) { full = true; break; }
+                held = false;
+                if (pending.last) done = true;
+            }
+            auxBytes.store(engine->auxBytes(), std::memory_order_relaxed);
+            publishArena(arena);
+            if (full)
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+};
+
+// Replay queued events for the current run, noting each in s.hist: at
+// most maxEvents, and stop early once budgetSec has elapsed.  Returns true when the run finished.
+static bool drainEvents(SortState& s, SortWorker& w,
+    long long maxEvents, double budgetSec)
+{
+    using Clock = std::chrono::steady_clock;
+    auto  t0 = Clock::now();
+    Event e;
+
+    for (long long k = 0; k < maxEvents; ) {
+        if (!w.events.pop(e)) break;
+        if (e.epoch != s.epoch) continue;      // left over from an old run
+        if (e.last) {
+            s.hist.complete = true;
+            s.hist.liveProgress = 1.f;
+            return true;
+        }
+
+        recordOp(s, e.op, e.progress);
+        applyOp(s, e.op);
+        s.stepIdx++;
+        s.progress = e.progress;
+        k++;
+
+        if ((k & 255) == 0 && std::chrono::duration<double>(
+            Clock::now() - t0).count() > budgetSec)
+            break;
+    }
+    return false;
+}
+
+//  Drawing helpers
+
+// One vertical-gradient quad into the current rlgl batch
+// (vertex order matches raylib's DrawRectangleGradientEx)
+static inline void pushQuad(float x, float y, float w, float h,
+    Color top, Color bot)
+{
+    rlColor4ub(top.r, top.g, top.b, top.a); rlVertex2f(x, y);
+    rlColor4ub(bot.r, bot.g, bot.b, bot.a); rlVertex2f(x, y + h);
+    rlColor4ub(bot.r, bot.g, bot.b, bot.a); rlVertex2f(x + w, y + h);
+    rlColor4ub(top.r, top.g, top.b, top.a); rlVertex2f(x + w, y);
+}
+
+// Stat card with a coloured accent stripe at the top
+static void drawCard(int x, int y, int w, int h,
+    const char* label, const char* val,
+    Color accent)
+{
+    DrawRectangleRounded(
+        { (float)x, (float)y, (float)w, (float)h },
+        0.18f, 8, C_CARD
+    );
+    DrawRectangleRounded(
+        { (float)x, (float)y, (float)w, 3.f },
+        0.3f, 4, accent
+    );
+    DrawText(label, x + 12, y + 9, 13, C_SUBTEXT);
+    DrawText(val, x + 12, y + 28, 20, C_TEXT);
+}
+
+// Outlined rounded rectangle (no fill)
+static void drawRoundBorder(float x, float y, float w, float h,
+    float radius, Color c)
+{
+    DrawRectangleRoundedLines({ x, y, w, h }, radius, 8, c);
+}
+
+//  Bar area  (animation-aware)
+//
+//  All bars go out as one stream of vertex-coloured quads (glow, gradient
+//  body, cap) through rlgl, so a frame costs a handful of batch uploads
+//  instead of several raylib shape calls — and a rounded-cap tessellation —
+//  per bar.  Bar colours are looked up by barState().
+//
+//  The bars live in a persistent render texture.  Each frame only the
+//  slots in the SortState's dirty range (plus the fanfare front) are
+//  cleared and redrawn; the texture is then blitted in one call.
+
+static const Color BAR_LO[4 + MAX_LANES] = {
+    C_BAR_LO, C_CMP_LO, C_SWP_LO, C_SRT_LO,
+    C_LANE_LO[0], C_LANE_LO[1], C_LANE_LO[2], C_LANE_LO[3],
+    C_LANE_LO[4], C_LANE_LO[5], C_LANE_LO[6], C_LANE_LO[7],
+};
+static const Color BAR_HI[4 + MAX_LANES] = {
+    C_BAR_HI, C_CMP_HI, C_SWP_HI, C_SRT_HI,
+    C_LANE_HI[0], C_LANE_HI[1], C_LANE_HI[2], C_LANE_HI[3],
+    C_LANE_HI[4], C_LANE_HI[5], C_LANE_HI[6], C_LANE_HI[7],
+};
+static const Color C_GRID = { 30, 36, 60, 255 };
+
+// Intro Sort fallback markers
+static const Color C_FB_INSERTION = { 110, 230, 255, 255 };
+static const Color C_FB_HEAP = { 255, 120, 200, 255 };
+
+// TimSort / External Sort run brackets, alternating
+static const Color C_RUN[2] = { { 255, 190, 90, 255 }, { 150, 200, 255, 255 } };
+
+// External Sort: the runs being merged
+static const Color C_MERGE = { 200, 140, 255, 255 };
+
+// Bars per rlBegin/rlEnd chunk; three quads each stays well inside
+// rlgl's default 8192-quad batch
+static const int BAR_CHUNK = 1024;
+
+//  Min / max / sum pyramid for the column view.  Leaves summarise fixed
+//  blocks of 2^BLOCK_SHIFT bars; a bottom-up segment tree combines them.
+//  A swap re-summarises its block and walks one path to the root, and a
+//  column query touches O(log n) nodes plus at most two partial blocks.
+
+struct MinMaxMip {
+    int n = 0;
+    int leaves = 1;               // power of two ≥ block count
+    std::vector<int>       mn, mx;
+    std::vector<long long> sum;
+
+    void build(const std::vector<int>& bars)
+    {
+        n = (int)bars.size();
+        int blocks = (n >> BLOCK_SHIFT) + 1;
+        leaves = 1;
+        while (leaves < blocks) leaves *= 2;
+
+        mn.assign(2 * leaves, INT_MAX);
+        mx.assign(2 * leaves, INT_MIN);
+        sum.assign(2 * leaves, 0);
+
+        for (int b = 0; b < blocks; b++) summarise(bars, b);
+        for (int k = leaves - 1; k >= 1; k--) combine(k);
+    }
+
+    // Block b's values changed
+    void refresh(const std::vector<int>& bars, int b)
+    {
+        summarise(bars, b);
+        for (int k = (b + leaves) / 2; k >= 1; k /= 2) combine(k);
+    }
+
+    // Aggregate over bars [lo, hi)
+    void query(const std::vector<int>& bars, int lo, int hi,
+        int& qmn, int& qmx, long long& qsum) const
+    {
+        qmn = INT_MAX; qmx = INT_MIN; qsum = 0;
+        auto scan = [&](int a, int b) {
+            for (int i = a; i < b; i++) {
+                qmn = std::min(qmn, bars[i]);
+                qmx = std::max(qmx, bars[i]);
+                qsum += bars[i];
+            }
+        };
+
+        int bLo = (lo >> BLOCK_SHIFT) + 1;        // first whole block
+        int bHi = hi >> BLOCK_SHIFT;              // one past last whole
+        if (bLo >= bHi) { scan(lo, hi); return; }
+
+        scan(lo, bLo << BLOCK_SHIFT);
+        scan(bHi << BLOCK_SHIFT, hi);
+
+        for (int l = bLo + leaves, r = bHi + leaves; l < r; l /= 2, r /= 2) {
+            if (l & 1) { take(l++, qmn, qmx, qsum); }
+            if (r & 1) { take(--r, qmn, qmx, qsum); }
+        }
+    }
+
+private:
+    void summarise(const std::vector<int>& bars, int b)
+    {
+        int k = b + leaves;
+        int a = b << BLOCK_SHIFT;
+        int e = std::min(n, a + (1 << BLOCK_SHIFT));
+        mn[k] = INT_MAX; mx[k] = INT_MIN; sum[k] = 0;
+        for (int i = a; i < e; i++) {
+            mn[k] = std::min(mn[k], bars[i]);
+            mx[k] = std::max(mx[k], bars[i]);
+            sum[k] += bars[i];
+        }
+    }
+
+    void combine(int k)
+    {
+        mn[k] = std::min(mn[2 * k], mn[2 * k + 1]);
+        mx[k] = std::max(mx[2 * k], mx[2 * k + 1]);
+        sum[k] = sum[2 * k] + sum[2 * k + 1];
+    }
+
+    void take(int k, int& qmn, int& qmx, long long& qsum) const
+    {
+        qmn = std::min(qmn, mn[k]);
+        qmx = std::max(qmx, mx[k]);
+        qsum += sum[k];
+    }
+};
+
+struct BarLayer {
+    RenderTexture2D rt = {};
+    bool  valid = false;          // false forces a full repaint
+    bool  fanfareWas = false;     // fanfare was running last frame
+    float fanfareLast = 0.f;      // its front position last frame
+
+    MinMaxMip mip;                // column view only
+    unsigned  mipGen = 0;         // SortState::generation it was built from
+};
+
+// First bar covered by screen column c (column view)
+static int colStart(int n, int c) { return (int)((long long)c * n / SW); }
+
+// Left edge of bar i's slot (or column position in the column view)
+static float barX(int n, int i)
+{
+    if (columnMode(n)) return (float)((double)i * SW / n);
+    return (float)(BAR_GAP + i * (slotWidth(n) + BAR_GAP));
+}
+
+// Colour state of the column covering bars [lo, hi)
+static int columnState(const SortState& s, int lo, int hi)
+{
+    for (auto& lane : s.lit)
+        for (int i : lane)
+            if (i >= lo && i < hi && s.colorMap[i] != 0)
+                return s.colorMap[i];
+    if (hi <= s.sortedBelow || lo >= s.sortedFrom) return 3;
+    return 0;
+}
+
+// Push the aggregated waveform for columns [c0, c1]: a translucent
+// min..max span with a gradient body up to the column mean
+static void pushColumns(const SortState& s, const AnimState& anim,
+    const MinMaxMip& mip, int c0, int c1)
+{
+    int   n = s.barCount();
+    float fanCol = anim.fanfarePos * SW / n;
+
+    rlSetTexture(0);
+    rlCheckRenderBatchLimit(4 * 2 * (c1 - c0 + 1));
+    rlBegin(RL_QUADS);
+
+    for (int c = c0; c <= c1; c++) {
+        int lo = colStart(n, c);
+        int hi = std::max(lo + 1, colStart(n, c + 1));
+        int qmn, qmx; long long qsum;
+        mip.query(s.bars, lo, hi, qmn, qmx, qsum);
+
+        float scale = 1.f;
+        if (anim.shuffleActive) {
+            float local = (anim.shuffleTimer - (float)c / SW) * 3.f;
+            local = std::max(0.f, std::min(1.f, local));
+            float inv = 1.f - local;
+            scale = 1.f - inv * inv * inv;
+        }
+
+        int   state = columnState(s, lo, hi);
+        Color cLo = BAR_LO[state];
+        Color cHi = BAR_HI[state];
+        float fanDist = std::abs((float)c - fanCol);
+        if (anim.fanfareActive && fanDist <= 4.f) {
+            float blend = 1.f - fanDist / 4.f;
+            cLo = lerpCol(C_SRT_LO, { 255, 255, 180, 255 }, blend);
+            cHi = lerpCol(C_SRT_HI, { 255, 255, 220, 255 }, blend);
+        }
+
+        float k = BAR_AREA_H * scale / n;
+        float yMax = BAR_AREA_Y + BAR_AREA_H - qmx * k;
+        float yMin = BAR_AREA_Y + BAR_AREA_H - qmn * k;
+        float yAvg = BAR_AREA_Y + BAR_AREA_H - (float)qsum / (hi - lo) * k;
+
+        Color span = { cHi.r, cHi.g, cHi.b, 70 };
+        pushQuad((float)c, yMax, 1.f, yMin - yMax + 1.f, span, span);
+        pushQuad((float)c, yAvg, 1.f,
+            (float)(BAR_AREA_Y + BAR_AREA_H) - yAvg, cHi, cLo);
+    }
+
+    rlEnd();
+}
+
+// Push quads for bars [lo, hi] into the current batch
+static void pushBars(const SortState& s, const AnimState& anim,
+    int lo, int hi)
+{
+    int n = s.barCount();
+    int bw = slotWidth(n);
+
+    rlSetTexture(0);
+
+    for (int c0 = lo; c0 <= hi; c0 += BAR_CHUNK) {
+        int c1 = std::min(hi + 1, c0 + BAR_CHUNK);
+        rlCheckRenderBatchLimit(4 * 3 * (c1 - c0));
+        rlBegin(RL_QUADS);
+
+        for (int i = c0; i < c1; i++) {
+            float t = (float)s.bars[i] / n;
+            int   bh = (int)(t * BAR_AREA_H);
+            int   bx = BAR_GAP + i * (bw + BAR_GAP);
+            int   by = BAR_AREA_Y + (BAR_AREA_H - bh);
+            if (bh <= 0) continue;
+
+            // ── Wave scale: bar rises from 0 → full height on shuffle ──
+            float scale = 1.f;
+            if (anim.shuffleActive) {
+                float local = (anim.shuffleTimer - (float)i / n) * 3.f;
+                local = std::max(0.f, std::min(1.f, local));
+                // Ease-out cubic
+                float inv = 1.f - local;
+                scale = 1.f - inv * inv * inv;
+            }
+
+            // ── Fanfare: bright gold flash near the sweep front ─────────
+            int   state = barState(s, i);
+            Color lo = BAR_LO[state];
+            Color hi = BAR_HI[state];
+            float fanDist = std::abs((float)i - anim.fanfarePos);
+
+            if (anim.fanfareActive && fanDist <= 4.f) {
+                float blend = 1.f - fanDist / 4.f;
+                lo = lerpCol(C_SRT_LO, { 255, 255, 180, 255 }, blend);
+                hi = lerpCol(C_SRT_HI, { 255, 255, 220, 255 }, blend);
+            }
+            else if (state == 1 || state == 2 || state >= 4) {
+                // Soft ambient halo behind an active bar
+                Color g = { hi.r, hi.g, hi.b, 35 };
+                pushQuad((float)(bx - 2), (float)(by - 3),
+                    (float)(bw + 4), (float)(bh + 3), g, g);
+            }
+
+            int dh = (int)(bh * scale);   // scaled height
+            int dy = by + (bh - dh);      // anchor to bottom
+            if (dh <= 0) continue;
+
+            pushQuad((float)bx, (float)dy, (float)bw, (float)dh, hi, lo);
+            pushQuad((float)bx, (float)dy, (float)bw,
+                (float)std::min(dh, 5), hi, hi);
+        }
+
+        rlEnd();
+    }
+}
+
+// Repaint whatever changed since last frame into the bar layer
+static void updateBarLayer(BarLayer& L, SortState& s, const AnimState& anim)
+{
+    int n = s.barCount();
+    int lo = s.dirtyLo;
+    int hi = s.dirtyHi;
+    s.dirtyLo = INT_MAX;
+    s.dirtyHi = -1;
+
+    if (anim.fanfareActive || L.fanfareWas) {
+        float from = L.fanfareWas ? L.fanfareLast : anim.fanfarePos;
+        lo = std::min(lo, (int)std::floor(from) - 5);
+        hi = std::max(hi, anim.fanfareActive
+            ? (int)std::ceil(anim.fanfarePos) + 5 : n - 1);
+    }
+    L.fanfareWas = anim.fanfareActive;
+    L.fanfareLast = anim.fanfarePos;
+
+    bool full = !L.valid || anim.shuffleActive;
+    bool cols = columnMode(n);
+
+    if (cols) {
+        // Bring the pyramid up to date before reading it
+        if (L.mipGen != s.generation || L.mip.n != n) {
+            L.mip.build(s.bars);
+            L.mipGen = s.generation;
+            full = true;
+        }
+        for (int b : s.dirtyBlocks) {
+            L.mip.refresh(s.bars, b);
+            s.blockDirty[b] = 0;
+        }
+        s.dirtyBlocks.clear();
+    }
+
+    if (full) { lo = 0; hi = n - 1; }
+    lo = std::max(lo, 0);
+    hi = std::min(hi, n - 1);
+    if (lo > hi) return;
+
+    // Each bar owns its slot plus the gap on either side, which is
+    // exactly the footprint of its glow.  In the column view a bar maps
+    // to the pixel column(s) covering it.
+    int bw = slotWidth(n);
+    int x0, x1;
+    if (cols) {
+        x0 = full ? 0 : (int)((long long)lo * SW / n);
+        x1 = full ? SW : (int)((long long)(hi + 1) * SW / n) + 1;
+        if (anim.fanfareActive || L.fanfareWas)
+            { x0 = std::max(0, x0 - 5); x1 = std::min(SW, x1 + 5); }
+        x1 = std::min(x1, SW);
+    }
+    else {
+        x0 = full ? 0 : lo * (bw + BAR_GAP);
+        x1 = full ? SW : (hi + 1) * (bw + BAR_GAP) + BAR_GAP;
+    }
+
+    BeginTextureMode(L.rt);
+    if (full) ClearBackground(C_BG);
+    else DrawRectangle(x0, BAR_AREA_Y - 3, x1 - x0, BAR_AREA_H + 3, C_BG);
+
+    // Subtle grid lines at 25 / 50 / 75 %
+    for (int pct = 25; pct < 100; pct += 25) {
+        int gy = BAR_AREA_Y + (int)(BAR_AREA_H * (1.f - pct / 100.f));
+        DrawLine(x0, gy, x1, gy, C_GRID);
+    }
+
+    if (cols) pushColumns(s, anim, L.mip, x0, x1 - 1);
+    else      pushBars(s, anim, lo, hi);
+    EndTextureMode();
+    L.valid = true;
+}
+
+static void drawBars(const BarLayer& L)
+{
+    // Render textures are stored bottom-up, hence the negative height
+    DrawTextureRec(L.rt.texture,
+        { 0.f, 0.f, (float)SW, -(float)SH }, { 0.f, 0.f }, WHITE);
+
+    for (int pct = 25; pct < 100; pct += 25) {
+        int gy = BAR_AREA_Y + (int)(BAR_AREA_H * (1.f - pct / 100.f));
+        DrawText(TextFormat("%d%%", pct),
+            5, gy - 13, 11, { 46, 54, 86, 255 });
+    }
+}
+
+//  Race mode  (V)
+//
+//  Two to six algorithms sort the same input side by side.  Each lane is
+//  a complete run of its own — SortState, worker thread, engine arena and
+//  bar layer — so lanes share nothing but the InputSpec they were dealt.
+//  All lanes are paced by one budget: every frame each is owed the same
+//  number of events, and whatever a lane could not replay (its ring ran
+//  dry, or the frame ran out of time) is carried over.  Replay only begins
+//  once every engine is built, so the lanes finish in order of how many
+//  events their algorithm needs on this input.
+
+static const int RACE_MIN = 2;
+static const int RACE_MAX = 6;
+static const int RACE_BANK = 4;       // frames of grant a lane may owe
+
+struct RaceLane {
+    SortState  s;
+    AnimState  anim;
+    BarLayer   layer;             // full-frame, scaled down into the pane
+    SortWorker worker;
+    long long  owed = 0;          // granted by the budget, not yet replayed
+    int        place = 0;         // 1 = winner · 0 racing · -1 refused
+
+    RaceLane()
+    {
+        layer.rt = LoadRenderTexture(SW, SH);
+        SetTextureFilter(layer.rt.texture, TEXTURE_FILTER_BILINEAR);
+    }
+    ~RaceLane() { UnloadRenderTexture(layer.rt); }
+};
+
+struct Race {
+    bool     on = false;
+    unsigned roster = 0;          // bit per Algorithm taking part
+    std::vector<std::unique_ptr<RaceLane>> lanes;   // in Algorithm order
+    bool     started = false;     // lanes handed to their workers
+    bool     running = false;
+    int      placed = 0;          // lanes that have finished
+    Pacer    pace;                // one rate for every lane
+    long long maxGrant = 4096;    // events per lane per frame at max speed
+
+    // Every lane has finished or was refused
+    bool done() const
+    {
+        for (auto& L : lanes)
+            if (L->place == 0) return false;
+        return started;
+    }
+};
+
+static int rosterSize(unsigned roster)
+{
+    int k = 0;
+    for (; roster; roster &= roster - 1) k++;
+    return k;
+}
+
+// Give every roster algorithm a lane holding src's input.  The bars are
+// regenerated from the same InputSpec, so each is a copy of src.initial.
+static void raceDeal(Race& r, const SortState& src)
+{
+    std::vector<Algorithm> algos;
+    for (int a = 0; a < ALGO_COUNT; a++)
+        if (r.roster >> a & 1) algos.push_back((Algorithm)a);
+
+    // Lanes (and their threads) are kept while the roster size holds
+    if (r.lanes.size() != algos.size()) {
+        r.lanes.clear();
+        for (size_t k = 0; k < algos.size(); k++)
+            r.lanes.push_back(std::make_unique<RaceLane>());
+    }
+
+    for (size_t k = 0; k < algos.size(); k++) {
+        RaceLane& L = *r.lanes[k];
+        if (L.s.started) L.s.epoch = L.worker.drop();
+        L.s.algo = algos[k];
+        L.s.opts = src.opts;
+        L.s.input = src.input;
+        L.s.sizeIdx = src.sizeIdx;
+        shuffle(L.s, L.anim);
+        L.layer.valid = false;
+        L.owed = 0;
+        L.place = 0;
+    }
+    r.started = r.running = false;
+    r.placed = 0;
+}
+
+// Build every lane's engine; a lane whose trace would be O(n²) sits out
+static void raceStart(Race& r)
+{
+    for (auto& L : r.lanes) {
+        if (traceTooLarge(L->s)) { L->place = -1; continue; }
+        resetRun(L->s);
+        L->s.epoch = L->worker.load(L->s.algo, L->s.bars, L->s.opts);
+        L->s.started = true;
+    }
+    r.started = true;
+}
+
+static void raceSetRunning(Race& r, bool on)
+{
+    r.running = on;
+    for (auto& L : r.lanes) {
+        if (!L->s.started || L->s.finished) continue;
+        L->s.running = on;
+        L->worker.setRunning(on);
+    }
+}
+
+// Every started lane's engine is built (the parallel ones record first)
+static bool raceReady(const Race& r)
+{
+    for (auto& L : r.lanes)
+        if (L->s.started && L->worker.readyEpoch.load(
+            std::memory_order_acquire) != L->s.epoch)
+            return false;
+    return true;
+}
+
+// Grant every running lane the same events at the speed's rate and replay
+// what each is owed.  At max speed the grant follows the time budget: it
+// grows while the lanes finish well inside it and shrinks once they don't,
+// so lanes stay level with each other and the frame rate holds.  A lane
+// that falls short carries the rest, up to RACE_BANK frames of grant, in
+// either mode.
+static void raceAdvance(Race& r, int speed, int group, float dt,
+    double budgetSec)
+{
+    using Clock = std::chrono::steady_clock;
+    for (auto& L : r.lanes) tickAnim(L->anim, L->s.barCount(), dt);
+    if (!r.running || !raceReady(r)) { r.pace.owed = 0; return; }
+
+    bool      sat = speedIsMax(speed);
+    long long grant = sat ? r.maxGrant : r.pace.grant(speed, group, dt);
+    if (!sat) r.pace.used(grant);
+
+    auto t0 = Clock::now();
+    std::vector<RaceLane*> finished;
+    double slice = budgetSec / r.lanes.size();
+    for (auto& L : r.lanes) {
+        SortState& s = L->s;
+        if (!s.running || s.finished) continue;
+        s.speedup = L->worker.speedup;
+        s.workers = L->worker.workers;
+
+        L->owed = std::min(L->owed + grant, RACE_BANK * grant);
+        long long before = s.stepIdx;
+        bool end = drainEvents(s, L->worker, L->owed, slice);
+        L->owed -= s.stepIdx - before;
+        if (end) {
+            finishRun(s, L->anim);
+            finished.push_back(L.get());
+        }
+    }
+
+    // The end marker can land a frame late; lanes finishing together are
+    // ranked by the events they needed
+    std::sort(finished.begin(), finished.end(),
+        [](const RaceLane* a, const RaceLane* b) {
+            return a->s.stepIdx < b->s.stepIdx;
+        });
+    for (RaceLane* L : finished) L->place = ++r.placed;
+    if (r.done()) r.running = false;
+
+    if (sat) {
+        double took = std::chrono::duration<double>(Clock::now() - t0).count();
+        if (took < 0.7 * budgetSec)  r.maxGrant += r.maxGrant / 4;
+        else if (took > budgetSec)   r.maxGrant -= r.maxGrant / 5;
+        r.maxGrant = std::max(256LL, std::min(r.maxGrant, 1LL << 24));
+    }
+}
+
+// Pane k of n: one column of panes up to three lanes, then two
+static Rectangle racePane(int k, int n)
+{
+    const float gap = 6.f;
+    int   cols = n <= 3 ? 1 : 2;
+    int   rows = (n + cols - 1) / cols;
+    float w = (SW - gap * (cols + 1)) / cols;
+    float h = (BAR_AREA_H + BOT_PAD - gap * (rows + 1)) / rows;
+    return { gap + (k % cols) * (w + gap),
+        BAR_AREA_Y + gap + (k / cols) * (h + gap), w, h };
+}
+
+static void drawRacePane(const RaceLane& L, Rectangle p)
+{
+    // The lane's bar strip (with the glow above it), scaled into the pane;
+    // render textures are stored bottom-up, hence the negative height
+    const int y0 = BAR_AREA_Y - 3;
+    const int y1 = BAR_AREA_Y + BAR_AREA_H;
+    DrawTexturePro(L.layer.rt.texture,
+        { 0.f, (float)(SH - y1), (float)SW, -(float)(y1 - y0) },
+        p, { 0.f, 0.f }, 0.f, WHITE);
+
+    const SortState& s = L.s;
+    Color edge = L.place > 0 ? C_SRT_HI : L.place < 0 ? C_SWP_HI : C_DIVIDER;
+    drawRoundBorder(p.x, p.y, p.width, p.height, 0.02f, edge);
+
+    // Progress along the bottom edge
+    float prog = s.finished ? 1.f : s.progress;
+    DrawRectangleRec({ p.x + 1, p.y + p.height - 4, (p.width - 2) * prog, 3.f },
+        { edge.r, edge.g, edge.b, 200 });
+
+    char ev[16], cmp[16], swp[16];
+    fmtSI(ev, sizeof(ev), (double)s.stepIdx);
+    fmtSI(cmp, sizeof(cmp), (double)s.comparisons);
+    fmtSI(swp, sizeof(swp), (double)s.swaps);
+    const char* head = TextFormat("%s     %s events   cmp %s   swp %s",
+        ALGO_NAMES[s.algo], ev, cmp, swp);
+    int hw = MeasureText(head, 14);
+    DrawRectangleRounded({ p.x + 6, p.y + 6, (float)(hw + 16), 24.f },
+        0.3f, 6, { 8, 10, 18, 190 });
+    DrawText(head, (int)p.x + 14, (int)p.y + 11, 14, C_TEXT);
+
+    // Finishing position, top right
+    if (L.place == 0) return;
+    static const char* ORD[RACE_MAX] = { "1st", "2nd", "3rd", "4th", "5th", "6th" };
+    const char* badge = L.place < 0 ? refusedLabel(L.s) : ORD[L.place - 1];
+    int bw = MeasureText(badge, 16) + 20;
+    Rectangle b = { p.x + p.width - bw - 8, p.y + 6, (float)bw, 26.f };
+    DrawRectangleRounded(b, 0.5f, 6, { edge.r, edge.g, edge.b, 45 });
+    drawRoundBorder(b.x, b.y, b.width, b.height, 0.5f, edge);
+    DrawText(badge, (int)b.x + 10, (int)b.y + 5, 16, edge);
+}
+
+//  UI panels  (each row is its own function)
+
+// The status pill's text and colour
+static const char* headerStatus(const SortState& s, const Race& race, Color& pc)
+{
+    if (race.on) {
+        bool loading = race.running && !raceReady(race);
+        pc = race.done() ? C_SRT_HI
+            : race.running ? C_CMP_HI
+            : C_SUBTEXT;
+        return race.done() ? "FINISHED"
+            : loading ? "BUILDING"
+            : race.running ? "RACING"
+            : "PAUSED";
+    }
+    bool refused = !s.started && traceTooLarge(s);
+    pc = s.finished ? C_SRT_HI
+        : s.running ? C_CMP_HI
+        : refused ? C_SWP_HI
+        : C_SUBTEXT;
+    return s.finished ? "SORTED"
+        : s.running ? "RUNNING"
+        : refused ? refusedLabel(s)
+        : "PAUSED";
+}
+
+// Everything in the header but the FPS counter
+static void drawHeader(const SortState& s, const Race& race)
+{
     DrawRectangle(0, 0, SW, HEADER_H, C_HEADER);
     DrawLine(0, HEADER_H, SW, HEADER_H, C_DIVIDER);
 
-    // Title
-    DrawText("SORTING VISUALIZER", 28, 12, 26, C_TEXT);
+    // Title
+    DrawText("SORTING VISUALIZER", 28, 12, 26, C_TEXT);
+
+    // Keyboard hints — two compact lines directly under the title
+    DrawText(
+        "SPACE  Start/Pause     R  Shuffle     G  Input Pattern     UP/DOWN  Speed"
+        "     V  Race  (1-0 / ENTER  Pick Lanes)",
+        28, 42, 12, C_SUBTEXT
+    );
+    DrawText(
+        "1-9, 0  Algorithm     LEFT/RIGHT  Cycle     A/D  Array Size"
+        "     H  Heap Arity     P/O  Quick Pivot/Partition"
+        "     I/L  Intro Cutoff/Depth     M  Memory Probe     N  Run Native",
+        28, 56, 12, C_SUBTEXT
+    );
+
+    // Current input, under the FPS counter (drawn per frame)
+    const char* in = TextFormat(s.hist.file ? "%s  ·  seed %u  ·  trace file"
+        : "%s  ·  seed %u  [G]", PAT_NAMES[s.input.pattern], s.input.seed);
+    DrawText(in, SW / 2 - MeasureText(in, 12) / 2 + 10, 32, 12, C_ACCENT);
+
+    // Complexity badge (lane count while racing)
+    const char* cx = race.on
+        ? TextFormat("RACE  ·  %d lanes", (int)race.lanes.size())
+        : ALGO_CMPLX[s.algo];
+    int         cxW = MeasureText(cx, 17) + 20;
+    DrawRectangleRounded(
+        { (float)(SW - cxW - 190), 15.f, (float)cxW, 38.f },
+        0.4f, 6, { 45, 55, 105, 255 }
+    );
+    DrawText(cx, SW - cxW - 180, 24, 17, C_ACCENT);
+
+    // Status pill
+    Color       pc;
+    const char* label = headerStatus(s, race, pc);
+    int psW = MeasureText(label, 15) + 24;
+    int psX = SW - psW - 18;
+    DrawRectangleRounded(
+        { (float)psX, 18.f, (float)psW, 32.f },
+        0.5f, 6, { pc.r, pc.g, pc.b, 45 }
+    );
+    drawRoundBorder((float)psX, 18.f, (float)psW, 32.f,
+        0.5f, { pc.r, pc.g, pc.b, 190 });
+    DrawText(label, SW - psW - 6, 26, 15, pc);
+}
+
+// While racing the lit buttons are the roster, and s.algo is outlined
+// as the ENTER cursor
+static void drawButtonRow(const SortState& s, unsigned roster)
+{
+    DrawRectangle(0, HEADER_H, SW, BTN_ROW_H, C_PANEL);
+    DrawLine(0, HEADER_H + BTN_ROW_H, SW, HEADER_H + BTN_ROW_H,
+        C_DIVIDER);
+
+    // Share the row between however many algorithms there are
+    const int btnGap = 8;
+    const int btnW = std::min(158,
+        (SW - 28 - (ALGO_COUNT - 1) * btnGap) / ALGO_COUNT);
+    const int btnH = 40;
+    const int startX =
+        (SW - (ALGO_COUNT * btnW + (ALGO_COUNT - 1) * btnGap)) / 2;
+
+    for (int i = 0; i < ALGO_COUNT; i++) {
+        int  bx = startX + i * (btnW + btnGap);
+        int  by = HEADER_H + (BTN_ROW_H - btnH) / 2;
+        bool active = roster ? (roster >> i & 1) != 0 : s.algo == i;
+
+        Color bg = active ? C_ACCENT : C_BTN;
+        Color tc = active ? C_BG : C_TEXT;
+
+        DrawRectangleRounded(
+            { (float)bx, (float)by, (float)btnW, (float)btnH },
+            0.22f, 8, bg
+        );
+        bool cursor = roster && s.algo == i;
+        if (!active || cursor) {
+            drawRoundBorder((float)bx, (float)by,
+                (float)btnW, (float)btnH,
+                0.22f, !cursor ? C_DIVIDER : active ? C_TEXT : C_ACCENT);
+        }
+
+        // Keys 1-9 then 0; the rest are reached with LEFT / RIGHT
+        char name[32];
+        if (i == HEAP && s.opts.heapArity != 2)
+            snprintf(name, sizeof(name), "%d-ary Heap", s.opts.heapArity);
+        else
+            snprintf(name, sizeof(name), "%s", ALGO_NAMES[i]);
+
+        char lbl[48];
+        if (i < 10)
+            snprintf(lbl, sizeof(lbl), "[%d] %s", (i + 1) % 10, name);
+        else
+            snprintf(lbl, sizeof(lbl), "%s", name);
+
+        int fs = 14;
+        while (fs > 10 && MeasureText(lbl, fs) > btnW - 10) fs--;
+        int tw = MeasureText(lbl, fs);
+        DrawText(lbl,
+            bx + (btnW - tw) / 2,
+            by + (btnH - fs) / 2,
+            fs, tc);
+    }
+}
+
+// Speed (UP / DOWN) at the right end of a stats row at sY
+static void drawSpeedBar(const SortState& s, int sY)
+{
+    int   spX = SW - 290;
+    int   spY = sY + 8;
+    DrawText("Speed", spX, spY, 13, C_SUBTEXT);
+
+    int   sBX = spX + 58;
+    int   sBY = spY + 1;
+    int   sBW = 160;
+    int   sBH = 12;
+    float sf = (s.speed - 1) / 9.f;
+    Color sc = lerpCol({ 60, 200, 100, 255 }, { 255, 90, 50, 255 }, sf);
+
+    DrawRectangleRounded(
+        { (float)sBX, (float)sBY, (float)sBW, (float)sBH },
+        0.5f, 6, C_BTN
+    );
+    if (sf > 0.f) {
+        DrawRectangleRounded(
+            { (float)sBX, (float)sBY, sBW * sf, (float)sBH },
+            0.5f, 6, sc
+        );
+    }
+    char rate[24];
+    fmtSpeed(rate, sizeof(rate), s.speed, s.group());
+    DrawText(rate, sBX + sBW + 8, spY, 18, C_TEXT);
+}
+
+// The progress bar, which doubles as the history scrubber
+static Rectangle scrubRect()
+{
+    return { (float)(14 + 6 * (160 + 8) + 8), (float)(HEADER_H + BTN_ROW_H + 10),
+        240.f, 10.f };
+}
+
+// How far the replay / the recording reach, exact once the run's totals
+// are known and the engine's own estimate until then
+static float runProgress(const SortState& s)
+{
+    if (s.finished) return 1.f;
+    if (!s.total.valid || s.total.events == 0) return s.progress;
+    return (float)std::min(1.0, (double)s.stepIdx / s.total.events);
+}
+
+static float recordedProgress(const SortState& s)
+{
+    const History& h = s.hist;
+    if (!s.total.valid || s.total.events == 0) return h.liveProgress;
+    return (float)std::min(1.0, (double)h.size() / s.total.events);
+}
+
+// Recorded event under screen x on the scrubber
+static long long scrubTarget(const SortState& s, float x)
+{
+    const History& h = s.hist;
+    Rectangle r = scrubRect();
+    float f = (x - r.x) / (r.width * std::max(recordedProgress(s), 1e-3f));
+    return (long long)std::llround(std::max(0.f, std::min(1.f, f)) * h.size());
+}
+
+static void drawStatsRow(const SortState& s)
+{
+    int sY = HEADER_H + BTN_ROW_H;
+    DrawRectangle(0, sY, SW, STATS_H, C_PANEL);
+    DrawLine(0, sY + STATS_H, SW, sY + STATS_H, C_DIVIDER);
+
+    // ── Stat cards ────────────────────────────
+    const int cW = 160;
+    const int cH = 50;
+    const int cGap = 8;
+    const int cX = 14;
+    const int cY = sY + 7;
+
+    char buf[64];
+
+    // "done / total" once the dry run has the totals
+    auto ofTotal = [&buf](long long v, long long total, bool known) {
+        if (!known) { snprintf(buf, sizeof(buf), "%lld", v); return; }
+        char a[16], b[16];
+        fmtSI(a, sizeof(a), (double)v);
+        fmtSI(b, sizeof(b), (double)total);
+        snprintf(buf, sizeof(buf), "%s / %s", a, b);
+    };
 
-    // Keyboard hints — two compact lines directly under the title
-    DrawText(
-        "SPACE  Start/Pause     R  Shuffle     UP/DOWN  Speed",
-        28, 42, 12, C_SUBTEXT
+    ofTotal(s.comparisons, s.total.comparisons, s.total.valid);
+    drawCard(cX + 0 * (cW + cGap), cY, cW, cH,
+        "Comparisons", buf, C_CMP_HI);
+
+    ofTotal(s.swaps, s.total.swaps, s.total.valid);
+    drawCard(cX + 1 * (cW + cGap), cY, cW, cH,
+        "Swaps", buf, C_SWP_HI);
+
+    // Steps of the current group size; events when ungrouped
+    char label[32];
+    int  g = s.group();
+    snprintf(buf, sizeof(buf), "%lld", (s.stepIdx + g - 1) / g);
+    if (g > 1) snprintf(label, sizeof(label), "Steps x%d [C]", g);
+    else       snprintf(label, sizeof(label), "Steps [C]");
+    drawCard(cX + 2 * (cW + cGap), cY, cW, cH,
+        label, buf, C_ACCENT);
+
+    snprintf(buf, sizeof(buf), "%d", s.barCount());
+    drawCard(cX + 3 * (cW + cGap), cY, cW, cH,
+        "Elements [A/D]", buf, C_SRT_HI);
+
+    // Parallel engines: measured 1-thread / N-thread wall-time ratio
+    if (s.workers > 0)
+        snprintf(buf, sizeof(buf), "%.2fx / %d", s.speedup, s.workers);
+    else
+        snprintf(buf, sizeof(buf), "-");
+    drawCard(cX + 4 * (cW + cGap), cY, cW, cH,
+        "Speedup / Threads", buf, C_LANE_HI[0]);
+
+    // Array elements loaded / stored (MemProbe)
+    if (s.mem.on) {
+        char r[16], w[16];
+        fmtSI(r, sizeof(r), (double)s.mem.reads);
+        fmtSI(w, sizeof(w), (double)s.mem.writes);
+        snprintf(buf, sizeof(buf), "%s / %s", r, w);
+    }
+    else snprintf(buf, sizeof(buf), "off");
+    drawCard(cX + 5 * (cW + cGap), cY, cW, cH,
+        "Reads / Writes [M]", buf, C_LANE_HI[1]);
+
+    // ── Progress bar / scrubber ───────────────
+    Rectangle pb = scrubRect();
+    int   pbX = (int)pb.x;
+    int   pbY = (int)pb.y;
+    int   pbW = (int)pb.width;
+    int   pbH = (int)pb.height;
+    float prog = runProgress(s);
+
+    DrawRectangleRounded(
+        { (float)pbX, (float)pbY, (float)pbW, (float)pbH },
+        0.5f, 6, C_BTN
     );
-    DrawText(
-        "1-6  Algorithm     A/D  Array Size",
-        28, 56, 12, C_SUBTEXT
+    if (prog > 0.f) {
+        DrawRectangleRounded(
+            { (float)pbX, (float)pbY, pbW * prog, (float)pbH },
+            0.5f, 6, C_ACCENT
+        );
+    }
+
+    // What has been recorded, and where in it the replay stands
+    const History& h = s.hist;
+    if (h.usable()) {
+        float rec = pbW * recordedProgress(s);
+        if (rec > pbW * prog)
+            DrawRectangleRounded({ pbX + pbW * prog, (float)pbY,
+                rec - pbW * prog, (float)pbH }, 0.5f, 6, { 60, 80, 140, 255 });
+        DrawCircle(pbX + (int)(pbW * prog), pbY + pbH / 2, 7.f, C_TEXT);
+    }
+    DrawText(h.usable() ? "Scrub  [, .]" : "Progress", pbX, sY + 26, 12,
+        C_SUBTEXT);
+
+    // What the run's arena took from the system, and in how many calls
+    if (s.arenaAllocs > 0) {
+        char ab[16];
+        fmtSI(ab, sizeof(ab), (double)s.arenaBytes);
+        const char* al = TextFormat("arena %sB in %lld allocs", ab, s.arenaAllocs);
+        DrawText(al, pbX + pbW - MeasureText(al, 12), sY + 26, 12, C_SUBTEXT);
+    }
+
+    if (s.mem.on) {
+        char aux[16];
+        fmtSI(aux, sizeof(aux), (double)s.mem.auxPeak);
+        double miss = s.mem.lineRefs
+            ? 100.0 * s.mem.misses / s.mem.lineRefs : 0.0;
+        double lpo = s.mem.ops ? (double)s.mem.lineRefs / s.mem.ops : 0.0;
+        DrawText(TextFormat("L1 miss %.1f%%   %.2f lines/op   aux %sB",
+            miss, lpo, aux), pbX, sY + 42, 12, C_SUBTEXT);
+    }
+
+    drawSpeedBar(s, sY);
+
+    // Time left at this speed, under the speed bar
+    if (s.etaSec >= 0.0 && !s.finished) {
+        char eta[24], ev[16];
+        fmtDuration(eta, sizeof(eta), s.etaSec);
+        fmtSI(ev, sizeof(ev), (double)s.total.events);
+        DrawText(TextFormat("ETA %s   of %s events", eta, ev),
+            SW - 290, sY + 30, 12, C_SUBTEXT);
+    }
+}
+
+// Race mode's stats row: the shared budget and the standings
+static void drawRaceRow(const SortState& s, const Race& race)
+{
+    int sY = HEADER_H + BTN_ROW_H;
+    DrawRectangle(0, sY, SW, STATS_H, C_PANEL);
+    DrawLine(0, sY + STATS_H, SW, sY + STATS_H, C_DIVIDER);
+
+    const int cW = 160;
+    const int cH = 50;
+    const int cGap = 8;
+    const int cX = 14;
+    const int cY = sY + 7;
+
+    char buf[64];
+
+    snprintf(buf, sizeof(buf), "%d / %d", (int)race.lanes.size(), RACE_MAX);
+    drawCard(cX + 0 * (cW + cGap), cY, cW, cH,
+        "Lanes [1-0/ENTER]", buf, C_ACCENT);
+
+    if (speedIsMax(s.speed)) fmtSI(buf, sizeof(buf),
+        (double)race.maxGrant * TARGET_FPS);
+    else fmtSI(buf, sizeof(buf), SPEED_RATE[s.speed - 1] * s.group());
+    drawCard(cX + 1 * (cW + cGap), cY, cW, cH,
+        "Events / Second", buf, C_CMP_HI);
+
+    snprintf(buf, sizeof(buf), "%d", s.barCount());
+    drawCard(cX + 2 * (cW + cGap), cY, cW, cH,
+        "Elements [A/D]", buf, C_SRT_HI);
+
+    snprintf(buf, sizeof(buf), "%d / %d", race.placed,
+        (int)race.lanes.size());
+    drawCard(cX + 3 * (cW + cGap), cY, cW, cH,
+        "Finished", buf, C_SWP_HI);
+
+    // Winner once there is one
+    const char* lead = "-";
+    for (auto& L : race.lanes)
+        if (L->place == 1) lead = ALGO_NAMES[L->s.algo];
+    DrawText("Winner", cX + 4 * (cW + cGap) + 8, sY + 10, 13, C_SUBTEXT);
+    DrawText(lead, cX + 4 * (cW + cGap) + 8, sY + 30, 20, C_TEXT);
+
+    drawSpeedBar(s, sY);
+}
+
+static void drawLegend(const SortState& s)
+{
+    int lx = SW - 210;
+    int ly = BAR_AREA_Y + 14;
+    int lanes = isParallel(s.algo) ? laneCount() : 0;
+    bool quick = s.algo == QUICK;
+    bool intro = s.algo == INTRO;
+    bool tim = s.algo == TIM;
+    bool ext = s.algo == EXTERNAL;
+    bool bitonic = s.algo == BITONIC;
+
+    DrawRectangleRounded(
+        { (float)(lx - 10), (float)(ly - 8), 210.f,
+          intro || ext ? 170.f : tim || bitonic ? 130.f
+          : lanes || quick ? 110.f : 90.f },
+        0.12f, 6, { 8, 10, 18, 190 }
+    );
+
+    struct Entry { Color c; const char* label; };
+    Entry entries[] = {
+        { C_BAR_HI, "Default"   },
+        { C_CMP_HI, "Comparing" },
+        { C_SWP_HI, "Swapping"  },
+        { C_SRT_HI, "Sorted"    },
+    };
+
+    for (int i = 0; i < 4; i++) {
+        DrawRectangleRounded(
+            { (float)lx, (float)(ly + i * 20), 14.f, 12.f },
+            0.35f, 4, entries[i].c
+        );
+        DrawText(entries[i].label,
+            lx + 20, ly + i * 20, 14, C_TEXT);
+    }
+
+    // One swatch per worker lane
+    for (int w = 0; w < lanes; w++) {
+        DrawRectangleRounded(
+            { (float)(lx + w * 10), (float)(ly + 80), 8.f, 12.f },
+            0.35f, 4, C_LANE_HI[w]
+        );
+    }
+    if (lanes)
+        DrawText("Workers", lx + lanes * 10 + 6, ly + 80, 14, C_TEXT);
+
+    // Active Quick Sort variant
+    if (quick) {
+        const char* part = s.opts.partition == PART_BLOCK
+            ? TextFormat("simd (%s)", SIMD_ISA)
+            : PART_NAMES[s.opts.partition];
+        DrawText(TextFormat("%s / %s", PIVOT_NAMES[s.opts.pivot], part),
+            lx, ly + 80, 14, C_ACCENT);
+    }
+
+    // Intro Sort settings and how often each fallback fired
+    if (intro) {
+        DrawText(TextFormat("cutoff %d  depth %d·log n",
+            s.opts.introCutoff, s.opts.introDepth), lx, ly + 80, 14, C_ACCENT);
+        DrawRectangleRounded({ (float)lx, (float)(ly + 102), 14.f, 6.f },
+            0.35f, 4, C_FB_INSERTION);
+        DrawRectangleRounded({ (float)lx, (float)(ly + 122), 14.f, 6.f },
+            0.35f, 4, C_FB_HEAP);
+        DrawText(TextFormat("pivot %s / %s",
+            PIVOT_NAMES[s.opts.pivot == PIVOT_LAST ? PIVOT_MEDIAN3 : s.opts.pivot],
+            PART_NAMES[s.opts.partition]), lx, ly + 138, 14, C_SUBTEXT);
+    }
+
+    // TimSort: runs currently on the stack
+    if (tim) {
+        DrawRectangleRounded({ (float)lx, (float)(ly + 84), 7.f, 6.f },
+            0.35f, 4, C_RUN[0]);
+        DrawRectangleRounded({ (float)(lx + 7), (float)(ly + 84), 7.f, 6.f },
+            0.35f, 4, C_RUN[1]);
+        DrawText(TextFormat("min run %d  gallop %d",
+            timMinRun(s.barCount()), TIM_MIN_GALLOP), lx, ly + 100, 14, C_SUBTEXT);
+    }
+
+    // External Sort: run brackets, the merge band and its settings
+    if (ext) {
+        DrawRectangleRounded({ (float)lx, (float)(ly + 84), 7.f, 6.f },
+            0.35f, 4, C_RUN[0]);
+        DrawRectangleRounded({ (float)(lx + 7), (float)(ly + 84), 7.f, 6.f },
+            0.35f, 4, C_RUN[1]);
+        DrawRectangleRounded({ (float)lx, (float)(ly + 104), 14.f, 4.f },
+            0.35f, 4, C_MERGE);
+        DrawText("Merging", lx + 20, ly + 100, 14, C_TEXT);
+        DrawText(TextFormat("run %d keys  fan-in %d",
+            extRunLen(s.opts, s.barCount()), s.opts.extFanIn),
+            lx, ly + 120, 14, C_ACCENT);
+        DrawText(TextFormat("runs by %s sort",
+            s.opts.extRunQuick ? "quick" : "merge"), lx, ly + 138, 14, C_SUBTEXT);
+    }
+
+    // Bitonic Sort: where it runs (the pass count is live)
+    if (bitonic) {
+        DrawText(!GPU_BUILT ? "GPU path not built"
+            : !s.gpuReady ? "GPU needs OpenGL 4.3"
+            : s.onGpu ? "on the GPU  [B]" : "on the CPU  [B]",
+            lx, ly + 80, 14, C_ACCENT);
+    }
+}
+
+// The legend's live counts, drawn over its cached part every frame
+static void drawLegendCounts(const SortState& s)
+{
+    int lx = SW - 210;
+    int ly = BAR_AREA_Y + 14;
+    if (s.algo == INTRO) {
+        DrawText(TextFormat("Insertion  x%d", s.insertionRuns),
+            lx + 20, ly + 98, 14, C_TEXT);
+        DrawText(TextFormat("Heap  x%d", s.heapRuns),
+            lx + 20, ly + 118, 14, C_TEXT);
+    }
+    if (s.algo == TIM || s.algo == EXTERNAL)
+        DrawText(TextFormat("Runs  %d", (int)s.runs.size()),
+            lx + 20, ly + 80, 14, C_TEXT);
+    if (s.algo == BITONIC && s.gpuPasses)
+        DrawText(TextFormat("pass %d / %d", s.gpuPass, s.gpuPasses),
+            lx, ly + 100, 14, C_SUBTEXT);
+}
+
+// Screen area the legend's panel covers
+static Rectangle legendRect()
+{
+    return { (float)(SW - 220), (float)(BAR_AREA_Y + 6), 210.f, 170.f };
+}
+
+//  Chrome cache
+//
+//  The header, the button row and the legend hardly ever change, yet
+//  drawing them is a few dozen rounded shapes, MeasureText() calls and
+//  formatted labels.  They are drawn once into a full-frame render
+//  texture, and again only when one of the inputs in ChromeKey changes;
+//  each frame blits the two areas and draws just the live parts (the
+//  FPS counter, the legend's counts) over them.  The texture holds
+//  premultiplied colour, so the legend's translucent panel composites
+//  over the bars exactly as if drawn directly.
+
+struct ChromeKey {
+    int      algo, n, heapArity, pivot, partition, introCutoff, introDepth;
+    int      extRunSize, extFanIn, extRunQuick;
+    int      pattern;
+    unsigned seed;
+    bool     file, race, gpuReady, onGpu;
+    unsigned roster;
+    int      lanes;
+    const char* status;           // headerStatus() returns literals
+
+    bool operator==(const ChromeKey& o) const
+    {
+        return std::tie(algo, n, heapArity, pivot, partition, introCutoff,
+            introDepth, extRunSize, extFanIn, extRunQuick, pattern, seed,
+            file, race, gpuReady, onGpu, roster, lanes, status)
+            == std::tie(o.algo, o.n, o.heapArity, o.pivot, o.partition,
+            o.introCutoff, o.introDepth, o.extRunSize, o.extFanIn,
+            o.extRunQuick, o.pattern, o.seed, o.file, o.race,
+            o.gpuReady, o.onGpu, o.roster, o.lanes, o.status);
+    }
+};
+
+struct ChromeCache {
+    RenderTexture2D rt = {};
+    bool            valid = false;
+    ChromeKey       key = {};
+    int             redraws = 0;
+};
+
+static ChromeKey chromeKey(const SortState& s, const Race& race)
+{
+    Color pc;
+    return { s.algo, s.barCount(), s.opts.heapArity, s.opts.pivot,
+        s.opts.partition, s.opts.introCutoff, s.opts.introDepth,
+        s.opts.extRunSize, s.opts.extFanIn, s.opts.extRunQuick,
+        s.input.pattern, s.input.seed, s.hist.file != nullptr, race.on,
+        s.gpuReady, s.onGpu, race.on ? race.roster : 0u, (int)race.lanes.size(),
+        headerStatus(s, race, pc) };
+}
+
+// Redraw the cached chrome if anything it shows has changed
+static void updateChrome(ChromeCache& c, const SortState& s, const Race& race)
+{
+    ChromeKey k = chromeKey(s, race);
+    if (c.valid && k == c.key) return;
+    c.key = k;
+    c.valid = true;
+    c.redraws++;
+
+    // Blend colour as usual but accumulate coverage in alpha, leaving
+    // premultiplied pixels over the transparent clear
+    BeginTextureMode(c.rt);
+    ClearBackground(BLANK);
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA,
+        RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+    drawHeader(s, race);
+    drawButtonRow(s, k.roster);
+    if (!race.on) drawLegend(s);
+    EndBlendMode();
+    EndTextureMode();
+}
+
+// Copy screen rectangle r of the cache (stored bottom-up) in place
+static void blitChrome(const ChromeCache& c, Rectangle r)
+{
+    DrawTextureRec(c.rt.texture,
+        { r.x, (float)SH - r.y - r.height, r.width, -r.height },
+        { r.x, r.y }, WHITE);
+}
+
+static void drawChrome(const ChromeCache& c, const SortState& s, const Race& race)
+{
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    blitChrome(c, { 0.f, 0.f, (float)SW, (float)(HEADER_H + BTN_ROW_H + 1) });
+    if (!race.on) blitChrome(c, legendRect());
+    EndBlendMode();
+
+    DrawText(TextFormat("FPS: %d", GetFPS()), SW / 2 - 30, 12, 16, C_SUBTEXT);
+    if (!race.on) drawLegendCounts(s);
+}
+
+// Brackets under the bars: the range Intro Sort's latest fallback is
+// sorting, or the runs on TimSort's stack
+static void drawRangeMarks(const SortState& s)
+{
+    if (s.finished) return;
+    int   n = s.barCount();
+    float y = (float)(BAR_AREA_Y + BAR_AREA_H + 4);
+
+    if (s.algo == INTRO && s.fallbackHi >= s.fallbackLo) {
+        float x0 = barX(n, s.fallbackLo);
+        float x1 = barX(n, s.fallbackHi + 1);
+        Color c = s.fallback == OP_MARK_HEAP ? C_FB_HEAP : C_FB_INSERTION;
+        DrawRectangleRec({ x0, y, std::max(2.f, x1 - x0), 5.f }, c);
+    }
+
+    if (s.algo == TIM || s.algo == EXTERNAL) {
+        for (size_t k = 0; k < s.runs.size(); k++) {
+            float x0 = barX(n, s.runs[k].first);
+            float x1 = barX(n, s.runs[k].second + 1);
+            DrawRectangleRec({ x0, y, std::max(1.f, x1 - x0 - 1.f), 5.f },
+                C_RUN[k & 1]);
+        }
+    }
+
+    // The runs the loser tree is merging, under their brackets
+    if (s.algo == EXTERNAL && s.fallback == OP_MARK_MERGE
+        && s.fallbackHi >= s.fallbackLo) {
+        float x0 = barX(n, s.fallbackLo);
+        float x1 = barX(n, s.fallbackHi + 1);
+        DrawRectangleRec({ x0, y + 7, std::max(2.f, x1 - x0), 3.f }, C_MERGE);
+    }
+}
+
+// Result of the last "run native" (N), under the stats row
+static void drawNativePanel(const NativeRunner& nr)
+{
+    if (!nr.busy() && !nr.hasResult()) return;
+
+    int px = 10;
+    int py = BAR_AREA_Y + 6;
+    DrawRectangleRounded(
+        { (float)px, (float)py, (float)(SW - 250), 48.f },
+        0.15f, 6, { 8, 10, 18, 200 }
     );
 
-    // FPS counter (centred)
-    DrawText(TextFormat("FPS: %d", GetFPS()),
-        SW / 2 - 30, 12, 16, C_SUBTEXT);
+    if (nr.busy()) {
+        DrawText("NATIVE RUN  running at full speed...",
+            px + 12, py + 8, 13, C_SUBTEXT);
+        return;
+    }
+
+    const HwSample& r = nr.result();
+    if (r.skipped) {
+        DrawText(TextFormat("NATIVE RUN [N]   %s   n = %d   skipped:"
+            " O(n²) runs only go up to %d elements",
+            ALGO_NAMES[r.algo], r.n, QUAD_LIMIT),
+            px + 12, py + 8, 13, C_SUBTEXT);
+        return;
+    }
+    DrawText(TextFormat("NATIVE RUN [N]   %s   n = %d   %.2f ms   %s",
+        ALGO_NAMES[r.algo], r.n, r.ms, r.sorted ? "sorted" : "NOT SORTED"),
+        px + 12, py + 8, 13, C_SUBTEXT);
+
+    // One column per counter, then IPC when both inputs were readable
+    char val[16], cell[48];
+    int  cx = px + 12;
+    for (int c = 0; c < HW_COUNT; c++) {
+        if (r.valid[c]) fmtSI(val, sizeof(val), (double)r.value[c]);
+        else snprintf(val, sizeof(val), "n/a");
+        snprintf(cell, sizeof(cell), "%s  %s", HW_NAMES[c], val);
+        DrawText(cell, cx, py + 26, 16, r.valid[c] ? C_TEXT : C_SUBTEXT);
+        cx += 210;
+    }
+    if (r.valid[HW_CYCLES] && r.valid[HW_INSTR] && r.value[HW_CYCLES] > 0)
+        snprintf(cell, sizeof(cell), "IPC  %.2f",
+            (double)r.value[HW_INSTR] / r.value[HW_CYCLES]);
+    else
+        snprintf(cell, sizeof(cell), "IPC  n/a");
+    DrawText(cell, cx, py + 26, 16, C_ACCENT);
+}
+
+// The dry-run totals of every algorithm for the current input (T)
+static void drawTallyPanel(const TallyTable& tt, const SortState& s)
+{
+    if (!tt.shown || !tt.matches(s.input, s.barCount(), s.opts)) return;
+
+    const int rowH = 18;
+    int px = 10;
+    int py = BAR_AREA_Y + 60;
+    int pw = 640;
+    int ph = 52 + ALGO_COUNT * rowH;
+    DrawRectangleRounded({ (float)px, (float)py, (float)pw, (float)ph },
+        0.04f, 6, { 8, 10, 18, 220 });
+
+    int ready = tt.ready();
+    DrawText(TextFormat("DRY RUN [T]   n = %d   %s   totals without replay%s",
+        tt.n(), PAT_NAMES[s.input.pattern], ready < ALGO_COUNT ? "..." : ""),
+        px + 12, py + 8, 13, C_SUBTEXT);
+
+    // Fewest events among the finished rows
+    long long best = LLONG_MAX;
+    for (int a = 0; a < ready; a++)
+        if (tt.row(a).valid) best = std::min(best, tt.row(a).events);
+
+    const int col[5] = { px + 12, px + 190, px + 310, px + 430, px + 550 };
+    const char* head[5] = { "Algorithm", "Comparisons", "Swaps", "Events", "ms" };
+    for (int c = 0; c < 5; c++)
+        DrawText(head[c], col[c], py + 28, 12, C_SUBTEXT);
+
+    char v[16];
+    for (int a = 0; a < ALGO_COUNT; a++) {
+        int   y = py + 46 + a * rowH;
+        const Tally& r = tt.row(a);
+        Color c = a == s.algo ? C_ACCENT : C_TEXT;
+        if (a < ready && r.valid && r.events == best) c = C_SRT_HI;
+        DrawText(ALGO_NAMES[a], col[0], y, 14, c);
+        if (a >= ready) continue;
+        if (!r.valid) {
+            DrawText("too large for a dry run", col[1], y, 14, C_SUBTEXT);
+            continue;
+        }
+        fmtSI(v, sizeof(v), (double)r.comparisons); DrawText(v, col[1], y, 14, c);
+        fmtSI(v, sizeof(v), (double)r.swaps);       DrawText(v, col[2], y, 14, c);
+        fmtSI(v, sizeof(v), (double)r.events);      DrawText(v, col[3], y, 14, c);
+        DrawText(TextFormat("%.2f", r.ms), col[4], y, 14, c);
+    }
+}
+
+//  Frame profiler  (F; X writes a Chrome trace)
+//
+//  Every frame is split into consecutive phases: enter() closes the open
+//  phase and opens the next, ProfScope does the same for one block.  The
+//  last PROF_FRAMES frames are kept, so the overlay can show per-phase
+//  milliseconds, a frame-time histogram and the worst spikes, and the
+//  last PROF_SECONDS of them can be written out for chrome://tracing or
+//  Perfetto.  Present is EndDrawing(): the buffer swap plus the wait for
+//  the frame rate, so a frame that has time to spare spends it there.
+
+enum ProfPhase : unsigned char {
+    PH_INPUT = 0, PH_ANIM, PH_STEP, PH_BARS, PH_UI, PH_PRESENT, PH_COUNT
+};
+
+static const char* PH_NAMES[PH_COUNT] = {
+    "Input", "Animation", "Step", "Bars", "UI", "Present"
+};
+static const Color PH_COLORS[PH_COUNT] = {
+    C_SUBTEXT, C_LANE_HI[1], C_CMP_HI, C_ACCENT, C_SRT_HI, { 70, 78, 110, 255 }
+};
+
+static const int    PROF_FRAMES = 2048;       // ring of recent frames
+static const double PROF_SECONDS = 10.0;      // what X exports
+
+struct ProfFrame {
+    double t0 = 0.0;              // s since the profiler started
+    double total = 0.0;           // to the next frame's start
+    float  beg[PH_COUNT] = {};    // s after t0
+    float  dur[PH_COUNT] = {};
+};
+
+class FrameProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    bool shown = false;
+
+    // Open a new frame (closing the last one) in its first phase
+    void frame(ProfPhase first)
+    {
+        double now = since();
+        if (count > 0) {
+            close();
+            ProfFrame& last = at(0);
+            last.total = now - last.t0;
+        }
+        head = (head + 1) % PROF_FRAMES;
+        count = std::min(count + 1, PROF_FRAMES);
+        at(0) = ProfFrame{};
+        at(0).t0 = now;
+        enter(first);
+    }
+
+    void enter(ProfPhase p)
+    {
+        close();
+        open = p;
+        openAt = since();
+    }
+
+    void close()
+    {
+        if (open == PH_COUNT || count == 0) return;
+        ProfFrame& f = at(0);
+        if (f.dur[open] == 0.f) f.beg[open] = (float)(openAt - f.t0);
+        f.dur[open] += (float)(since() - openAt);
+        open = PH_COUNT;
+    }
+
+    // Finished frames: 0 is the newest
+    int frames() const { return std::max(0, count - 1); }
+    const ProfFrame& past(int k) const { return at(k + 1); }
+
+    // Chrome trace JSON of the last PROF_SECONDS; false if unwritable
+    bool exportTrace(const char* path, int& written) const
+    {
+        FILE* f = std::fopen(path, "w");
+        if (!f) return false;
+        std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"tid\":1,\"args\":{\"name\":\"render\"}}");
+        written = 0;
+        double newest = frames() ? past(0).t0 : 0.0;
+        for (int k = frames() - 1; k >= 0; k--) {
+            const ProfFrame& fr = past(k);
+            if (newest - fr.t0 > PROF_SECONDS) continue;
+            auto ev = [&](const char* name, double ts, double dur) {
+                std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+                    "\"tid\":1,\"ts\":%.1f,\"dur\":%.1f}",
+                    name, ts * 1e6, dur * 1e6);
+            };
+            ev("Frame", fr.t0, fr.total);
+            for (int p = 0; p < PH_COUNT; p++)
+                if (fr.dur[p] > 0.f)
+                    ev(PH_NAMES[p], fr.t0 + fr.beg[p], fr.dur[p]);
+            written++;
+        }
+        std::fprintf(f, "\n]}\n");
+        return std::fclose(f) == 0;
+    }
+
+    // What the overlay says about the last export
+    char   note[96] = "";
+    double noteAt = -1e9;
+
+    double since() const
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+private:
+    Clock::time_point start = Clock::now();
+    ProfFrame ring[PROF_FRAMES];
+    int       head = 0;           // the frame being recorded
+    int       count = 0;
+    ProfPhase open = PH_COUNT;    // PH_COUNT: none
+    double    openAt = 0.0;
+
+    ProfFrame&       at(int k)       { return ring[(head - k + PROF_FRAMES) % PROF_FRAMES]; }
+    const ProfFrame& at(int k) const { return ring[(head - k + PROF_FRAMES) % PROF_FRAMES]; }
+};
+
+// One phase for the rest of a block
+struct ProfScope {
+    FrameProfiler& p;
+    ProfScope(FrameProfiler& prof, ProfPhase ph) : p(prof) { p.enter(ph); }
+    ~ProfScope() { p.close(); }
+};
+
+// Per-phase times, the frame-time histogram and the worst frames
+static void drawProfiler(const FrameProfiler& fp)
+{
+    if (!fp.shown) return;
+
+    const int hw = 300;           // histogram: one pixel per frame
+    int pw = hw + 28;
+    int px = SW - pw - 10;
+    int py = BAR_AREA_Y + 6;
+    int ph = 330;
+    DrawRectangleRounded({ (float)px, (float)py, (float)pw, (float)ph },
+        0.04f, 6, { 8, 10, 18, 225 });
+    DrawText("FRAME PROFILER [F]   export [X]", px + 14, py + 8, 13, C_SUBTEXT);
+
+    int n = fp.frames();
+    if (n == 0) return;
+
+    // Average over the last second and worst over the ring, per phase
+    double avg[PH_COUNT] = {}, worst[PH_COUNT] = {}, frameAvg = 0.0;
+    int    recent = 0;
+    double newest = fp.past(0).t0;
+    for (int k = 0; k < n; k++) {
+        const ProfFrame& f = fp.past(k);
+        bool inLast = newest - f.t0 < 1.0;
+        if (inLast) { recent++; frameAvg += f.total; }
+        for (int p = 0; p < PH_COUNT; p++) {
+            if (inLast) avg[p] += f.dur[p];
+            worst[p] = std::max(worst[p], (double)f.dur[p]);
+        }
+    }
+
+    int y = py + 30;
+    DrawText("phase          avg ms    max ms", px + 14, y, 12, C_SUBTEXT);
+    y += 16;
+    for (int p = 0; p < PH_COUNT; p++, y += 16) {
+        DrawRectangle(px + 14, y + 3, 8, 8, PH_COLORS[p]);
+        DrawText(PH_NAMES[p], px + 28, y, 12, C_TEXT);
+        DrawText(TextFormat("%7.2f", 1e3 * avg[p] / recent), px + 112, y, 12, C_TEXT);
+        DrawText(TextFormat("%7.2f", 1e3 * worst[p]), px + 180, y, 12, C_TEXT);
+    }
+    DrawText(TextFormat("frame  %.2f ms avg   %.0f fps", 1e3 * frameAvg / recent,
+        frameAvg > 0 ? recent / frameAvg : 0.0), px + 14, y + 2, 12, C_ACCENT);
+    y += 24;
+
+    // Newest frame on the right, each column stacked by phase; the line
+    // is the target frame period, the scale twice that
+    const int   hh = 80;
+    const float period = 1.f / TARGET_FPS;
+    int   hx = px + 14;
+    DrawRectangle(hx, y, hw, hh, { 20, 24, 40, 255 });
+    for (int k = 0; k < std::min(n, hw); k++) {
+        const ProfFrame& f = fp.past(k);
+        int   x = hx + hw - 1 - k;
+        float base = 0.f;
+        for (int p = 0; p < PH_COUNT; p++) {
+            float h0 = std::min(1.f, base / (2 * period)) * hh;
+            base += f.dur[p];
+            float h1 = std::min(1.f, base / (2 * period)) * hh;
+            if (h1 > h0)
+                DrawRectangle(x, y + hh - (int)h1, 1, std::max(1, (int)h1 - (int)h0),
+                    PH_COLORS[p]);
+        }
+        if (f.total > 1.5 * period)
+            DrawRectangle(x, y, 1, 3, C_SWP_HI);
+    }
+    DrawLine(hx, y + hh / 2, hx + hw, y + hh / 2, C_SWP_LO);
+    y += hh + 8;
+
+    // The three worst frames still in the ring, with their biggest phase
+    int top[3] = { -1, -1, -1 };
+    for (int k = 0; k < n; k++) {
+        double v = fp.past(k).total;
+        for (int j = 0; j < 3; j++) {
+            if (top[j] < 0 || v > fp.past(top[j]).total) {
+                for (int m = 2; m > j; m--) top[m] = top[m - 1];
+                top[j] = k;
+                break;
+            }
+        }
+    }
+    DrawText("worst frames", px + 14, y, 12, C_SUBTEXT);
+    y += 16;
+    for (int j = 0; j < 3 && top[j] >= 0; j++, y += 15) {
+        const ProfFrame& f = fp.past(top[j]);
+        int big = 0;              // Present only waits out the frame
+        for (int p = 1; p < PH_PRESENT; p++) if (f.dur[p] > f.dur[big]) big = p;
+        DrawText(TextFormat("%6.2f ms   %s %.2f ms   %.1f s ago", 1e3 * f.total,
+            PH_NAMES[big], 1e3 * f.dur[big], newest - f.t0),
+            px + 14, y, 12, f.total > 1.5 * period ? C_SWP_HI : C_TEXT);
+    }
+
+    if (fp.since() - fp.noteAt < 4.0)
+        DrawText(fp.note, px + 14, py + ph - 18, 12, C_ACCENT);
+}
+
+static void drawUI(const SortState& s, const Race& race,
+    const ChromeCache& chrome)
+{
+    drawChrome(chrome, s, race);
+    if (race.on) {
+        drawRaceRow(s, race);
+        for (size_t k = 0; k < race.lanes.size(); k++)
+            drawRacePane(*race.lanes[k],
+                racePane((int)k, (int)race.lanes.size()));
+        return;
+    }
+    drawStatsRow(s);
+    drawRangeMarks(s);
+}
+
+//  GPU Bitonic Sort  (B in the window, --gpu-bench)
+//
+//  A bitonic pass is K/2 independent comparators, so the GPU runs
+//  BitonicEngine's network with one thread per comparator.  The keys
+//  live in a shader storage buffer padded to a power of two with
+//  INT_MAX, which sorts to the end.  In the window every (k, j) pass is
+//  one dispatch, so the network can be watched pass by pass; the bars
+//  are drawn straight from the buffer by a vertex shader and the array
+//  is read back once, when the run ends.  Flat out (--gpu-bench) the
+//  passes with j below GPU_BLOCK are fused: a stage's tail, and every
+//  stage up to k = GPU_BLOCK at the start, runs in one dispatch that
+//  sorts 1024-key blocks in shared memory.
+//
+//  Compute shaders need OpenGL 4.3, and glMemoryBarrier, which rlgl
+//  doesn't wrap.  The path is compiled only with -DSORTVIS_GPU, which
+//  looks the barrier up through GLFW and so needs GLFW linked (raylib's
+//  own static library bundles it).  Without the flag, or with anything
+//  less than GL 4.3 (macOS, older drivers, a raylib built for GL 3.3),
+//  init() is false and Bitonic Sort runs on the CPU engine only.
+
+static const int GPU_GROUP    = 256;        // pass kernel: threads per group
+static const int GPU_BLOCK    = 1024;       // block kernel: keys per group
+static const int GPU_MAX_KEYS = 1 << 24;    // keeps a pass under 65535 groups
+
+// One (k, j) pass over K keys.  Thread t owns comparator t, as in
+// bitonicPair().
+static const char* GPU_PASS_SRC = R"(#version 430
+layout(local_size_x = 256) in;
+layout(std430, binding = 0) buffer Keys { int v[]; };
+uniform int k;
+uniform int j;
+uniform int pairs;             // comparators in the pass, K/2
+void main()
+{
+    uint t = gl_GlobalInvocationID.x;
+    if (t >= uint(pairs)) return;
+    uint i = 2u * t - (t & uint(j - 1));
+    uint p = j == k / 2 ? i ^ uint(k - 1) : i + uint(j);
+    int a = v[i], b = v[p];
+    if (b < a) { v[i] = b; v[p] = a; }
+}
+)";
+
+// Passes j .. 1 of stage k inside each 1024-key block, in shared
+// memory; k = 0 runs every stage up to 1024 instead
+static const char* GPU_BLOCK_SRC = R"(#version 430
+layout(local_size_x = 512) in;
+layout(std430, binding = 0) buffer Keys { int v[]; };
+uniform int k;
+uniform int j;
+shared int s[1024];
+void exchange(uint t, int kk, int jj)
+{
+    uint i = 2u * t - (t & uint(jj - 1));
+    uint p = jj == kk / 2 ? i ^ uint(kk - 1) : i + uint(jj);
+    int a = s[i], b = s[p];
+    if (b < a) { s[i] = b; s[p] = a; }
+    barrier();
+}
+void main()
+{
+    uint t = gl_LocalInvocationID.x, base = gl_WorkGroupID.x * 1024u;
+    s[t] = v[base + t];
+    s[t + 512u] = v[base + t + 512u];
+    barrier();
+    if (k == 0) {
+        for (int kk = 2; kk <= 1024; kk *= 2)
+            for (int jj = kk / 2; jj >= 1; jj /= 2) exchange(t, kk, jj);
+    }
+    else {
+        for (int jj = j; jj >= 1; jj /= 2) exchange(t, k, jj);
+    }
+    v[base + t] = s[t];
+    v[base + t + 512u] = s[t + 512u];
+}
+)";
+
+// Six vertices per bar, placed from the key they sample; no vertex
+// buffer at all
+static const char* GPU_BARS_VS = R"(#version 430
+layout(std430, binding = 0) readonly buffer Keys { int v[]; };
+uniform ivec2 bars;            // bars drawn, keys
+uniform vec4  geom;            // first x, pitch, bar width
+uniform vec4  area;            // top, height, screen width, screen height
+out float t;
+void main()
+{
+    int   bar = gl_VertexID / 6, c = gl_VertexID % 6;
+    int   i = min(bars.y - 1,
+        int((float(bar) + 0.5) * float(bars.y) / float(bars.x)));
+    float h = float(v[i]) / float(bars.y) * area.y;
+    float cx = c == 1 || c == 2 || c == 4 ? 1.0 : 0.0;
+    float cy = c == 2 || c == 4 || c == 5 ? 1.0 : 0.0;
+    float x = geom.x + float(bar) * geom.y + cx * geom.z;
+    float y = area.x + area.y - cy * h;
+    t = cy;
+    gl_Position = vec4(x / area.z * 2.0 - 1.0, 1.0 - y / area.w * 2.0, 0.0, 1.0);
+}
+)";
+
+static const char* GPU_BARS_FS = R"(#version 430
+in float t;
+uniform vec4 lo;
+uniform vec4 hi;
+out vec4 color;
+void main() { color = mix(lo, hi, t); }
+)";
+
+// rlgl has no memory barrier and raylib's GLFW is the loader at hand
+using GlProc = void (*)(void);
+#if defined(SORTVIS_GPU)
+extern "C" GlProc glfwGetProcAddress(const char* name);
+static GlProc glProc(const char* name) { return glfwGetProcAddress(name); }
+#else
+static GlProc glProc(const char*) { return nullptr; }
+#endif
+#if defined(_WIN32)
+#define GPU_APIENTRY __stdcall
+#else
+#define GPU_APIENTRY
+#endif
+static const unsigned GL_SSBO_AND_UPDATE_BARRIERS = 0x2000 | 0x0200;
+
+struct GpuBitonic {
+    struct Pass {
+        int  k, j;                // k = 0: all stages up to GPU_BLOCK
+        bool block;               // j .. 1 in shared memory
+        long long compares;       // comparators among the real n keys
+    };
+
+    unsigned passProg = 0, blockProg = 0, barsProg = 0, vao = 0;
+    void (GPU_APIENTRY* barrier)(unsigned) = nullptr;
+
+    unsigned ssbo = 0;
+    int      cap = 0;             // keys the buffer was made for
+    int      n = 0, K = 0;
+    std::vector<Pass> passes;
+    int      done = 0;            // passes dispatched
+    double   owed = 0.0;          // window pacing: passes, fractions carry
+
+    bool canSort() const { return passProg && blockProg && barrier; }
+    bool canDraw() const { return barsProg && vao; }
+
+    // Needs the window's context; false without OpenGL 4.3 or when
+    // built without SORTVIS_GPU
+    bool init()
+    {
+        if (!GPU_BUILT || rlGetVersion() != RL_OPENGL_43) return false;
+        passProg = compute(GPU_PASS_SRC);
+        blockProg = compute(GPU_BLOCK_SRC);
+        barsProg = rlLoadShaderCode(GPU_BARS_VS, GPU_BARS_FS);
+        vao = rlLoadVertexArray();
+        barrier = (void (GPU_APIENTRY*)(unsigned))glProc("glMemoryBarrier");
+        return canSort();
+    }
+
+    // Before CloseWindow()
+    void unload()
+    {
+        for (unsigned p : { passProg, blockProg, barsProg })
+            if (p) rlUnloadShaderProgram(p);
+        if (vao) rlUnloadVertexArray(vao);
+        if (ssbo) rlUnloadShaderBuffer(ssbo);
+        *this = GpuBitonic();
+    }
+
+    // Upload v and plan its passes, fused (block kernel) or one per (k, j)
+    void load(const std::vector<int>& v, bool fused)
+    {
+        n = (int)v.size();
+        K = fused ? GPU_BLOCK : 2;
+        while (K < n) K <<= 1;
+        std::vector<int> keys(K, INT_MAX);
+        std::copy(v.begin(), v.end(), keys.begin());
+        if (K != cap) {
+            if (ssbo) rlUnloadShaderBuffer(ssbo);
+            ssbo = rlLoadShaderBuffer(K * sizeof(int), keys.data(),
+                RL_DYNAMIC_COPY);
+            cap = K;
+        }
+        else rlUpdateShaderBuffer(ssbo, keys.data(), K * sizeof(int), 0);
+
+        passes.clear();
+        done = 0;
+        owed = 0.0;
+        long long tail = 0;       // passes j < GPU_BLOCK of any stage
+        for (int j = GPU_BLOCK / 2; j >= 1; j /= 2) tail += bitonicPairs(n, j);
+        if (fused) {
+            long long head = 0;
+            for (int k = 2; k <= GPU_BLOCK; k *= 2)
+                for (int j = k / 2; j >= 1; j /= 2) head += bitonicPairs(n, j);
+            passes.push_back({ 0, 0, true, head });
+        }
+        for (int k = fused ? 2 * GPU_BLOCK : 2; k <= K; k *= 2) {
+            int last = fused ? GPU_BLOCK : 1;
+            for (int j = k / 2; j >= last; j /= 2)
+                passes.push_back({ k, j, false, bitonicPairs(n, j) });
+            if (fused) passes.push_back({ k, GPU_BLOCK / 2, true, tail });
+        }
+    }
+
+    bool finished() const { return done == (int)passes.size(); }
+
+    // Dispatch up to count more passes; returns their comparators
+    long long run(int count)
+    {
+        long long cmp = 0;
+        for (; count > 0 && !finished(); count--) {
+            const Pass& p = passes[done++];
+            unsigned prog = p.block ? blockProg : passProg;
+            int pairs = K / 2;
+            rlEnableShader(prog);
+            uniform(prog, "k", &p.k, RL_SHADER_UNIFORM_INT);
+            uniform(prog, "j", &p.j, RL_SHADER_UNIFORM_INT);
+            if (!p.block) uniform(prog, "pairs", &pairs, RL_SHADER_UNIFORM_INT);
+            rlBindShaderBuffer(ssbo, 0);
+            rlComputeShaderDispatch(p.block ? K / GPU_BLOCK
+                : (pairs + GPU_GROUP - 1) / GPU_GROUP, 1, 1);
+            rlDisableShader();
+            barrier(GL_SSBO_AND_UPDATE_BARRIERS);
+            cmp += p.compares;
+        }
+        return cmp;
+    }
+
+    // Blocks until the dispatched passes are done
+    void wait()
+    {
+        int probe;
+        rlReadShaderBuffer(ssbo, &probe, sizeof(probe), 0);
+    }
+
+    void read(std::vector<int>& v)
+    {
+        v.resize(n);
+        rlReadShaderBuffer(ssbo, v.data(), n * sizeof(int), 0);
+    }
+
+    // count bars from x0 every pitch pixels, each sampling its share
+    // of the keys, over the bar area
+    void draw(int count, float x0, float pitch, float width,
+        Color lo, Color hi)
+    {
+        int   nb[2] = { count, n };
+        float geom[4] = { x0, pitch, width, 0.f };
+        float area[4] = { (float)BAR_AREA_Y, (float)BAR_AREA_H,
+                          (float)SW, (float)SH };
+        float clo[4] = { lo.r / 255.f, lo.g / 255.f, lo.b / 255.f, 1.f };
+        float chi[4] = { hi.r / 255.f, hi.g / 255.f, hi.b / 255.f, 1.f };
+
+        rlDrawRenderBatchActive();            // what raylib queued goes first
+        rlEnableShader(barsProg);
+        uniform(barsProg, "bars", nb, RL_SHADER_UNIFORM_IVEC2);
+        uniform(barsProg, "geom", geom, RL_SHADER_UNIFORM_VEC4);
+        uniform(barsProg, "area", area, RL_SHADER_UNIFORM_VEC4);
+        uniform(barsProg, "lo", clo, RL_SHADER_UNIFORM_VEC4);
+        uniform(barsProg, "hi", chi, RL_SHADER_UNIFORM_VEC4);
+        rlBindShaderBuffer(ssbo, 0);
+        rlEnableVertexArray(vao);
+        rlDrawVertexArray(0, 6 * count);
+        rlDisableVertexArray();
+        rlDisableShader();
+    }
+
+private:
+    static unsigned compute(const char* src)
+    {
+        unsigned sh = rlCompileShader(src, RL_COMPUTE_SHADER);
+        return sh ? rlLoadComputeShaderProgram(sh) : 0;
+    }
+
+    static void uniform(unsigned prog, const char* name, const void* v,
+        int type)
+    {
+        rlSetUniform(rlGetLocationUniform(prog, name), v, type, 1);
+    }
+};
 
-    // Complexity badge
-    const char* cx = ALGO_CMPLX[s.algo];
-    int         cxW = MeasureText(cx, 17) + 20;
-    DrawRectangleRounded(
-        { (float)(SW - cxW - 190), 15.f, (float)cxW, 38.f },
-        0.4f, 6, { 45, 55, 105, 255 }
-    );
-    DrawText(cx, SW - cxW - 180, 24, 17, C_ACCENT);
+// The window's run is on the GPU (B, Bitonic Sort only)
+static bool onGpu(const SortState& s)
+{
+    return s.onGpu && s.gpuReady && s.algo == BITONIC && !s.hist.file;
+}
 
-    // Status pill
-    const char* label = s.finished ? "SORTED"
-        : s.running ? "RUNNING"
-        : "PAUSED";
-    Color pc = s.finished ? C_SRT_HI
-        : s.running ? C_CMP_HI
-        : C_SUBTEXT;
+// Passes per second at each speed level; 0 = the rest at once
+static const double GPU_PASS_RATE[SPEED_LEVELS] = {
+    1, 2, 4, 8, 15, 30, 60, 120, 480, 0
+};
 
-    int psW = MeasureText(label, 15) + 24;
-    int psX = SW - psW - 18;
-    DrawRectangleRounded(
-        { (float)psX, 18.f, (float)psW, 32.f },
-        0.5f, 6, { pc.r, pc.g, pc.b, 45 }
-    );
-    drawRoundBorder((float)psX, 18.f, (float)psW, 32.f,
-        0.5f, { pc.r, pc.g, pc.b, 190 });
-    DrawText(label, SW - psW - 6, 26, 15, pc);
+// Dispatch this frame's passes.  At the end the array is read back
+// into the bars (the run's only readback) and true returned.
+static bool gpuAdvance(GpuBitonic& g, SortState& s, float dt)
+{
+    double rate = GPU_PASS_RATE[s.speed - 1];
+    int    left = (int)g.passes.size() - g.done;
+    g.owed += rate ? rate * dt : left;
+    int    k = std::min(left, (int)g.owed);
+    g.owed -= k;
+
+    s.comparisons += g.run(k);
+    s.gpuPass = g.done;
+    s.progress = g.passes.empty() ? 1.f : (float)g.done / g.passes.size();
+    if (!g.finished()) return false;
+
+    g.read(s.bars);
+    s.generation++;                       // the column pyramid is stale
+    touch(s, 0, s.barCount() - 1);
+    return true;
 }
 
-static void drawButtonRow(const SortState& s)
+// The bar area drawn from the GPU's copy of the keys: the same slots as
+// pushBars(), or one bar per pixel column in the column view
+static void drawGpuBars(GpuBitonic& g)
 {
-    DrawRectangle(0, HEADER_H, SW, BTN_ROW_H, C_PANEL);
-    DrawLine(0, HEADER_H + BTN_ROW_H, SW, HEADER_H + BTN_ROW_H,
-        C_DIVIDER);
+    for (int pct = 25; pct < 100; pct += 25) {
+        int gy = BAR_AREA_Y + (int)(BAR_AREA_H * (1.f - pct / 100.f));
+        DrawLine(0, gy, SW, gy, C_GRID);
+    }
+    if (columnMode(g.n))
+        g.draw(SW, 0.f, 1.f, 1.f, C_BAR_LO, C_BAR_HI);
+    else {
+        int bw = slotWidth(g.n);
+        g.draw(g.n, (float)BAR_GAP, (float)(bw + BAR_GAP), (float)bw,
+            C_BAR_LO, C_BAR_HI);
+    }
+    for (int pct = 25; pct < 100; pct += 25) {
+        int gy = BAR_AREA_Y + (int)(BAR_AREA_H * (1.f - pct / 100.f));
+        DrawText(TextFormat("%d%%", pct),
+            5, gy - 13, 11, { 46, 54, 86, 255 });
+    }
+}
 
-    const int btnW = 158;
-    const int btnH = 40;
-    const int btnGap = 10;
-    const int startX =
-        (SW - (ALGO_COUNT * btnW + (ALGO_COUNT - 1) * btnGap)) / 2;
+//  Headless benchmark  (--bench)
+//
+//  Runs buildSteps() and a full replay for every algorithm at each size
+//  without touching raylib, then times the untraced native kernel on the
+//  same input, and prints one CSV (or JSON) row per run.
+//
+//    --sizes 1000,10000,...   element counts   (default 1k,10k,100k,1M)
+//    --quad-limit N           skip O(n²) engines above N   (default 20000)
+//    --heap-arity 2|4         children per Heap Sort node   (default 2)
+//    --mem                    fill the memory columns (slows the replay)
+//    --pivot last|median3|ninther          Quick Sort pivot rule
+//    --partition lomuto|branchless|hoare|simd   Quick Sort partition
+//    --intro-cutoff N         Intro Sort insertion cutoff   (default 16)
+//    --intro-depth F          Intro Sort heap fallback past F·log2 n (2)
+//    --run-size N             External Sort keys per run  (default n/16)
+//    --fan-in K               External Sort runs per merge, 2 … 16  (4)
+//    --run-sort merge|quick   External Sort run formation  (default merge)
+//    --pattern P1,P2,...      input patterns (default uniform)
+//    --types T1,T2,...        int32,int64,float,kv  (default int32); the
+//                             other types time the native kernel only
+//    --seed S                 input seed      (default 12345)
+//    --swaps K                nearly-sorted: random swaps (default n/100)
+//    --json                   JSON array instead of CSV
+
+#if defined(_WIN32)
+// <windows.h> clashes with raylib's names, so declare just what we need
+struct BenchMemCounters {
+    unsigned long cb, PageFaultCount;
+    size_t PeakWorkingSetSize, WorkingSetSize;
+    size_t QuotaPeakPagedPoolUsage, QuotaPagedPoolUsage;
+    size_t QuotaPeakNonPagedPoolUsage, QuotaNonPagedPoolUsage;
+    size_t PagefileUsage, PeakPagefileUsage;
+};
+extern "C" __declspec(dllimport) void* __stdcall GetCurrentProcess(void);
+extern "C" __declspec(dllimport) int __stdcall K32GetProcessMemoryInfo(
+    void* process, BenchMemCounters* counters, unsigned long cb);
+#endif
 
-    for (int i = 0; i < ALGO_COUNT; i++) {
-        int  bx = startX + i * (btnW + btnGap);
-        int  by = HEADER_H + (BTN_ROW_H - btnH) / 2;
-        bool active = (s.algo == i);
+// Peak resident set size of this process in KiB
+static long long peakRssKB()
+{
+#if defined(_WIN32)
+    BenchMemCounters pmc = {};
+    pmc.cb = sizeof(pmc);
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return (long long)(pmc.PeakWorkingSetSize / 1024);
+    return -1;
+#else
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+    return ru.ru_maxrss / 1024;   // bytes on macOS
+#else
+    return ru.ru_maxrss;          // KiB on Linux
+#endif
+#endif
+}
 
-        Color bg = active ? C_ACCENT : C_BTN;
-        Color tc = active ? C_BG : C_TEXT;
+// Reset the peak-RSS high-water mark so each run reports its own peak
+// (Linux only; elsewhere the figure is the process-wide peak so far)
+static void resetPeakRss()
+{
+#if defined(__linux__)
+    if (FILE* f = std::fopen("/proc/self/clear_refs", "w")) {
+        std::fputs("5", f);
+        std::fclose(f);
+    }
+#endif
+}
 
-        DrawRectangleRounded(
-            { (float)bx, (float)by, (float)btnW, (float)btnH },
-            0.22f, 8, bg
-        );
-        if (!active) {
-            drawRoundBorder((float)bx, (float)by,
-                (float)btnW, (float)btnH,
-                0.22f, C_DIVIDER);
-        }
+// Engine and input options shared by --bench and --record; consumes
+// argv[i] (and its value) and returns true when it was one of them
+// Index of val among names[0 .. count), or -1 once reported on stderr
+static int nameIndex(const char* what, const char* val,
+    const char* const* names, int count)
+{
+    for (int k = 0; k < count; k++)
+        if (!std::strcmp(val, names[k])) return k;
+    std::fprintf(stderr, "unknown %s: %s\n", what, val);
+    return -1;
+}
 
-        char lbl[48];
-        snprintf(lbl, sizeof(lbl), "[%d] %s", i + 1, ALGO_NAMES[i]);
-        int tw = MeasureText(lbl, 14);
-        DrawText(lbl,
-            bx + (btnW - tw) / 2,
-            by + (btnH - 14) / 2,
-            14, tc);
+// 1 if argv[i] and its value were an engine or input option (i moves
+// past them), 0 if not one, -1 for a value that names nothing
+static int parseRunArg(int argc, char** argv, int& i,
+    EngineOptions& opts, InputSpec& input)
+{
+    if (i + 1 >= argc) return 0;
+    const char* arg = argv[i];
+    const char* val = argv[i + 1];
+
+    if (!std::strcmp(arg, "--heap-arity"))
+        opts.heapArity = std::atoi(val) == 4 ? 4 : 2;
+    else if (!std::strcmp(arg, "--intro-cutoff"))
+        opts.introCutoff = std::max(0, std::atoi(val));
+    else if (!std::strcmp(arg, "--intro-depth"))
+        opts.introDepth = std::max(0, std::atoi(val));
+    else if (!std::strcmp(arg, "--pivot")) {
+        int k = nameIndex("pivot rule", val, PIVOT_NAMES, PIVOT_COUNT);
+        if (k < 0) return -1;
+        opts.pivot = (PivotRule)k;
     }
+    else if (!std::strcmp(arg, "--partition")) {
+        int k = nameIndex("partition scheme", val, PART_NAMES, PART_COUNT);
+        if (k < 0) return -1;
+        opts.partition = (PartitionScheme)k;
+    }
+    else if (!std::strcmp(arg, "--run-size"))
+        opts.extRunSize = std::max(0, std::atoi(val));
+    else if (!std::strcmp(arg, "--fan-in"))
+        opts.extFanIn = std::max(2, std::min(EXT_FANIN_MAX, std::atoi(val)));
+    else if (!std::strcmp(arg, "--run-sort"))
+        opts.extRunQuick = !std::strcmp(val, "quick");
+    else if (!std::strcmp(arg, "--seed"))
+        input.seed = (unsigned)std::strtoul(val, nullptr, 10);
+    else if (!std::strcmp(arg, "--swaps"))
+        input.swaps = std::max(0, std::atoi(val));
+    else
+        return 0;
+    i++;
+    return 1;
 }
 
-static void drawStatsRow(const SortState& s)
+// Element types the templated native kernels are timed on.  The bars
+// map to each type order-preservingly: int64 moves the (non-negative)
+// value into the upper 32 bits, so every key needs the full width, and
+// kv carries the input index as its payload.
+enum ElemType { ELEM_INT32, ELEM_INT64, ELEM_FLOAT, ELEM_KV, ELEM_COUNT };
+
+static const char* ELEM_NAMES[ELEM_COUNT] = { "int32", "int64", "float", "kv" };
+
+// ms for the native kernel on `bars` converted by make(x, i), or -1 when
+// the algorithm has no kernel for T
+template <typename T, typename Less, typename Make>
+static double timeNativeAs(Algorithm algo, const std::vector<int>& bars,
+    const EngineOptions& opts, Less less, Make make, bool& sorted,
+    IoStats& io)
 {
-    int sY = HEADER_H + BTN_ROW_H;
-    DrawRectangle(0, sY, SW, STATS_H, C_PANEL);
-    DrawLine(0, sY + STATS_H, SW, sY + STATS_H, C_DIVIDER);
+    using Clock = std::chrono::steady_clock;
+    int n = (int)bars.size();
+    std::vector<T> v(n);
+    for (int i = 0; i < n; i++) v[i] = make(bars[i], i);
+
+    auto t0 = Clock::now();
+    if (!nativeSortAs(algo, v.data(), n, opts, less, &io)) return -1.0;
+    double msec = std::chrono::duration<double, std::milli>(
+        Clock::now() - t0).count();
+    sorted = std::is_sorted(v.begin(), v.end(), less);
+    return msec;
+}
 
-    // ── Stat cards ────────────────────────────
-    const int cW = 160;
-    const int cH = 50;
-    const int cGap = 8;
-    const int cX = 14;
-    const int cY = sY + 7;
+static double timeNativeType(ElemType type, Algorithm algo,
+    const std::vector<int>& bars, const EngineOptions& opts, bool& sorted,
+    IoStats& io)
+{
+    switch (type) {
+    case ELEM_INT64:
+        return timeNativeAs<long long>(algo, bars, opts, std::less<long long>(),
+            [](int x, int) { return (long long)x << 32; }, sorted, io);
+    case ELEM_FLOAT:
+        return timeNativeAs<float>(algo, bars, opts, std::less<float>(),
+            [](int x, int) { return (float)x; }, sorted, io);
+    case ELEM_KV:
+        return timeNativeAs<KeyValue>(algo, bars, opts, KeyLess(),
+            [](int x, int i) { return KeyValue{ x, i }; }, sorted, io);
+    default:
+        return timeNativeAs<int>(algo, bars, opts, std::less<int>(),
+            [](int x, int) { return x; }, sorted, io);
+    }
+}
 
-    char buf[64];
+static int runBench(int argc, char** argv)
+{
+    std::vector<int> sizes = { 1000, 10000, 100000, 1000000 };
+    int  quadLimit = QUAD_LIMIT;
+    bool json = false;
+    bool mem = false;
+    EngineOptions opts;
+    InputSpec input;
+    input.seed = 12345;
+    std::vector<InputPattern> patterns = { PAT_UNIFORM };
+    std::vector<ElemType>     types = { ELEM_INT32 };
+
+    for (int i = 1; i < argc; i++) {
+        int run = parseRunArg(argc, argv, i, opts, input);
+        if (run < 0) return 1;
+        if (run) continue;
+        if (!std::strcmp(argv[i], "--json")) {
+            json = true;
+        }
+        else if (!std::strcmp(argv[i], "--mem")) {
+            mem = true;
+        }
+        else if (!std::strcmp(argv[i], "--quad-limit") && i + 1 < argc) {
+            quadLimit = std::atoi(argv[++i]);
+        }
+        else if (!std::strcmp(argv[i], "--pattern") && i + 1 < argc) {
+            patterns.clear();
+            for (char* tok = std::strtok(argv[++i], ",");
+                tok; tok = std::strtok(nullptr, ",")) {
+                int k = nameIndex("pattern", tok, PAT_NAMES, PAT_COUNT);
+                if (k < 0) return 1;
+                patterns.push_back((InputPattern)k);
+            }
+            if (patterns.empty()) patterns.push_back(PAT_UNIFORM);
+        }
+        else if (!std::strcmp(argv[i], "--types") && i + 1 < argc) {
+            types.clear();
+            for (char* tok = std::strtok(argv[++i], ",");
+                tok; tok = std::strtok(nullptr, ",")) {
+                int k = nameIndex("element type", tok, ELEM_NAMES, ELEM_COUNT);
+                if (k < 0) return 1;
+                types.push_back((ElemType)k);
+            }
+            if (types.empty()) types.push_back(ELEM_INT32);
+        }
+        else if (!std::strcmp(argv[i], "--sizes") && i + 1 < argc) {
+            sizes.clear();
+            for (char* tok = std::strtok(argv[++i], ",");
+                tok; tok = std::strtok(nullptr, ","))
+                if (std::atoi(tok) > 1) sizes.push_back(std::atoi(tok));
+        }
+    }
 
-    snprintf(buf, sizeof(buf), "%lld", s.comparisons);
-    drawCard(cX + 0 * (cW + cGap), cY, cW, cH,
-        "Comparisons", buf, C_CMP_HI);
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
 
-    snprintf(buf, sizeof(buf), "%lld", s.swaps);
-    drawCard(cX + 1 * (cW + cGap), cY, cW, cH,
-        "Swaps", buf, C_SWP_HI);
+    bool first = true;
+
+    if (json) std::printf("[\n");
+    else std::printf("algorithm,pattern,n,build_ms,replay_ms,wall_ms,events,"
+        "comparisons,swaps,peak_rss_kb,speedup,native_ms,native_melem_s,"
+        "reads,writes,aux_peak_bytes,l1_miss_pct,lines_per_op,"
+        "arena_bytes,arena_allocs,sorted,type,io_bytes,io_mb_s\n");
+
+    for (InputPattern pat : patterns)
+    for (int n : sizes)
+    for (ElemType type : types) {
+        for (int a = 0; a < ALGO_COUNT; a++) {
+            if ((isQuadratic((Algorithm)a) || degradesOn((Algorithm)a, opts, pat))
+                && n > quadLimit) {
+                std::fprintf(stderr, "skip %s on %s at n=%d (--quad-limit %d)\n",
+                    ALGO_NAMES[a], PAT_NAMES[pat], n, quadLimit);
+                continue;
+            }
 
-    snprintf(buf, sizeof(buf), "%zu / %zu",
-        s.stepIdx, s.steps.size());
-    drawCard(cX + 2 * (cW + cGap), cY, cW, cH,
-        "Steps", buf, C_ACCENT);
+            // Only int32 has engines (and parallel and integer-key kernels).
+            // The parallel engines' recorded trace is capped as in the
+            // window; past it only their native kernel is timed.
+            bool engineRun = type == ELEM_INT32
+                && !(isParallel((Algorithm)a) && n > PARALLEL_TRACE_MAX);
+            if (type != ELEM_INT32
+                && (isParallel((Algorithm)a) || isIntegerKey((Algorithm)a))) {
+                std::fprintf(stderr, "skip %s as %s (int32 only)\n",
+                    ALGO_NAMES[a], ELEM_NAMES[type]);
+                continue;
+            }
 
-    snprintf(buf, sizeof(buf), "%d", s.barCount());
-    drawCard(cX + 3 * (cW + cGap), cY, cW, cH,
-        "Elements [A/D]", buf, C_SRT_HI);
+            SortState s;
+            s.algo = (Algorithm)a;
+            s.opts = opts;
+            s.mem.on = mem;
+            s.input = input;
+            s.input.pattern = pat;
+            fillBars(s, n);
+
+            double  nativeMs;
+            bool    sorted = true;
+            IoStats io;
+            if (type == ELEM_INT32) {
+                std::vector<int> native = s.bars;
+                auto n0 = Clock::now();
+                nativeSort(s.algo, native, s.opts, &io);
+                nativeMs = ms(Clock::now() - n0);
+                sorted = std::is_sorted(native.begin(), native.end());
+            }
+            else {
+                nativeMs = timeNativeType(type, s.algo, s.bars, s.opts,
+                    sorted, io);
+            }
+            double melems = nativeMs > 0 ? n / (nativeMs * 1000.0) : 0.0;
+            long long ioBytes = io.bytesRead + io.bytesWritten;
+            double ioMBs = io.ioSec > 0 ? ioBytes / (io.ioSec * 1e6) : 0.0;
+            resetPeakRss();
+
+            auto t0 = Clock::now(), t1 = t0, t2 = t0;
+            if (engineRun) {
+                buildSteps(s);
+                t1 = Clock::now();
+                while (advance(s, 1 << 16)) {}
+                t2 = Clock::now();
+                sorted = sorted && std::is_sorted(s.bars.begin(), s.bars.end());
+            }
+            long long rss = peakRssKB();
+            const MemProbe& m = s.mem;
+            double miss = m.lineRefs ? 100.0 * m.misses / m.lineRefs : 0.0;
+            double lpo = m.ops ? (double)m.lineRefs / m.ops : 0.0;
+
+            if (json) {
+                std::printf("%s  {\"algorithm\": \"%s\", "
+                    "\"pattern\": \"%s\", \"n\": %d, "
+                    "\"build_ms\": %.3f, \"replay_ms\": %.3f, "
+                    "\"wall_ms\": %.3f, \"events\": %lld, "
+                    "\"comparisons\": %lld, \"swaps\": %lld, "
+                    "\"peak_rss_kb\": %lld, \"speedup\": %.3f, "
+                    "\"native_ms\": %.3f, \"native_melem_s\": %.2f, "
+                    "\"reads\": %lld, \"writes\": %lld, "
+                    "\"aux_peak_bytes\": %zu, \"l1_miss_pct\": %.2f, "
+                    "\"lines_per_op\": %.3f, \"arena_bytes\": %zu, "
+                    "\"arena_allocs\": %lld, \"sorted\": %s, "
+                    "\"type\": \"%s\", \"io_bytes\": %lld, "
+                    "\"io_mb_s\": %.1f}",
+                    first ? "" : ",\n", ALGO_NAMES[a], PAT_NAMES[pat], n,
+                    ms(t1 - t0), ms(t2 - t1), ms(t2 - t0), s.stepIdx,
+                    s.comparisons, s.swaps, rss, s.speedup,
+                    nativeMs, melems, m.reads, m.writes, m.auxPeak,
+                    miss, lpo, s.arena.bytes(), s.arena.allocs(),
+                    sorted ? "true" : "false", ELEM_NAMES[type],
+                    ioBytes, ioMBs);
+            }
+            else {
+                std::printf("%s,%s,%d,%.3f,%.3f,%.3f,%lld,%lld,%lld,%lld,%.3f,"
+                    "%.3f,%.2f,%lld,%lld,%zu,%.2f,%.3f,%zu,%lld,%d,%s,%lld,%.1f\n",
+                    ALGO_NAMES[a], PAT_NAMES[pat], n,
+                    ms(t1 - t0), ms(t2 - t1), ms(t2 - t0), s.stepIdx,
+                    s.comparisons, s.swaps, rss, s.speedup,
+                    nativeMs, melems, m.reads, m.writes, m.auxPeak,
+                    miss, lpo, s.arena.bytes(), s.arena.allocs(),
+                    sorted ? 1 : 0, ELEM_NAMES[type], ioBytes, ioMBs);
+            }
+            std::fflush(stdout);
+            first = false;
+        }
+    }
 
-    // ── Progress bar ───────────────
-    int   pbX = cX + 4 * (cW + cGap) + 8;
-    int   pbY = sY + 10;
-    int   pbW = 240;
-    int   pbH = 10;
-    float prog = s.steps.empty()
-        ? 0.f
-        : (float)s.stepIdx / (float)s.steps.size();
+    if (json) std::printf("\n]\n");
+    return 0;
+}
 
-    DrawRectangleRounded(
-        { (float)pbX, (float)pbY, (float)pbW, (float)pbH },
-        0.5f, 6, C_BTN
-    );
-    if (prog > 0.f) {
-        DrawRectangleRounded(
-            { (float)pbX, (float)pbY, pbW * prog, (float)pbH },
-            0.5f, 6, C_ACCENT
-        );
+//  GPU benchmark  (--gpu-bench)
+//
+//  Opens a hidden window for its OpenGL context and, for each size,
+//  sorts one input with GpuBitonic (fused passes) and with the native
+//  bitonic, Intro and Radix kernels, printing one CSV row per size.
+//  Upload and readback are timed apart from the sort, whose clock stops
+//  on a 4-byte read that waits for the last pass.  sorted means all four
+//  results agree and are in order.
+//
+//    --sizes 1000000,...      element counts, at most 16M
+//                             (default 1M, 2M, 4M, 8M, 16M)
+//    --pattern P              input pattern   (default uniform)
+//    plus --seed, --swaps and the engine options of --bench
+
+static int runGpuBench(int argc, char** argv)
+{
+    std::vector<int> sizes = { 1 << 20, 1 << 21, 1 << 22, 1 << 23, 1 << 24 };
+    EngineOptions opts;
+    InputSpec input;
+    input.seed = 12345;
+
+    for (int i = 1; i < argc; i++) {
+        int run = parseRunArg(argc, argv, i, opts, input);
+        if (run < 0) return 1;
+        if (run) continue;
+        if (!std::strcmp(argv[i], "--pattern") && i + 1 < argc) {
+            int k = nameIndex("pattern", argv[++i], PAT_NAMES, PAT_COUNT);
+            if (k < 0) return 1;
+            input.pattern = (InputPattern)k;
+        }
+        else if (!std::strcmp(argv[i], "--sizes") && i + 1 < argc) {
+            sizes.clear();
+            for (char* tok = std::strtok(argv[++i], ",");
+                tok; tok = std::strtok(nullptr, ","))
+                if (std::atoi(tok) > 1)
+                    sizes.push_back(std::min(GPU_MAX_KEYS, std::atoi(tok)));
+        }
     }
-    DrawText("Progress", pbX, sY + 26, 12, C_SUBTEXT);
 
-    // ── Speed bar ─────
-    int   spX = SW - 290;
-    int   spY = sY + 8;
-    DrawText("Speed", spX, spY, 13, C_SUBTEXT);
+    // Without compute shaders the CPU kernels are still timed and the
+    // GPU columns read 0
+    GpuBitonic gpu;
+    if (GPU_BUILT) {
+        SetTraceLogLevel(LOG_WARNING);    // keep raylib's log off the CSV
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        InitWindow(64, 64, "gpu bench");
+    }
+    bool onGpu = GPU_BUILT && gpu.init();
+    if (!GPU_BUILT)
+        std::fprintf(stderr, "--gpu-bench: built without SORTVIS_GPU, "
+            "timing the CPU kernels only\n");
+    else if (!onGpu)
+        std::fprintf(stderr, "--gpu-bench: no compute shaders (needs "
+            "OpenGL 4.3, have rlgl version %d), timing the CPU kernels only\n",
+            rlGetVersion());
+
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
 
-    int   sBX = spX + 58;
-    int   sBY = spY + 1;
-    int   sBW = 160;
-    int   sBH = 12;
-    float sf = (s.speed - 1) / 9.f;
-    Color sc = lerpCol({ 60, 200, 100, 255 }, { 255, 90, 50, 255 }, sf);
+    std::printf("n,passes,gpu_upload_ms,gpu_sort_ms,gpu_readback_ms,"
+        "gpu_melem_s,cpu_bitonic_ms,cpu_intro_ms,cpu_radix_ms,sorted\n");
+
+    for (int n : sizes) {
+        std::vector<int> bars, gpuOut;
+        makeInput(bars, n, input);
+
+        auto t0 = Clock::now(), t1 = t0, t2 = t0, t3 = t0;
+        if (onGpu) {
+            gpu.load(bars, true);
+            gpu.wait();
+            t1 = Clock::now();
+            gpu.run((int)gpu.passes.size());
+            gpu.wait();
+            t2 = Clock::now();
+            gpu.read(gpuOut);
+            t3 = Clock::now();
+        }
 
-    DrawRectangleRounded(
-        { (float)sBX, (float)sBY, (float)sBW, (float)sBH },
-        0.5f, 6, C_BTN
-    );
-    if (sf > 0.f) {
-        DrawRectangleRounded(
-            { (float)sBX, (float)sBY, sBW * sf, (float)sBH },
-            0.5f, 6, sc
-        );
+        // The CPU kernels on the same input
+        double cpuMs[3];
+        std::vector<int> cpuOut[3];
+        const Algorithm cpuAlgo[3] = { BITONIC, INTRO, RADIX };
+        for (int c = 0; c < 3; c++) {
+            cpuOut[c] = bars;
+            auto c0 = Clock::now();
+            nativeSort(cpuAlgo[c], cpuOut[c], opts);
+            cpuMs[c] = ms(Clock::now() - c0);
+        }
+        bool sorted = std::is_sorted(cpuOut[1].begin(), cpuOut[1].end())
+            && (!onGpu || gpuOut == cpuOut[1]) && cpuOut[0] == cpuOut[1]
+            && cpuOut[2] == cpuOut[1];
+
+        double sortMs = ms(t2 - t1);
+        std::printf("%d,%d,%.3f,%.3f,%.3f,%.2f,%.3f,%.3f,%.3f,%d\n",
+            n, (int)gpu.passes.size(), ms(t1 - t0), sortMs, ms(t3 - t2),
+            sortMs > 0 ? n / (sortMs * 1000.0) : 0.0,
+            cpuMs[0], cpuMs[1], cpuMs[2], sorted ? 1 : 0);
+        std::fflush(stdout);
     }
-    DrawText(TextFormat("%d", s.speed),
-        sBX + sBW + 8, spY, 18, C_TEXT);
 
+    gpu.unload();
+    if (GPU_BUILT) CloseWindow();
+    return 0;
 }
 
-static void drawLegend()
+//  Trace recorder  (--record FILE)
+//
+//  Runs one engine headless and streams its events to a trace file the
+//  window can replay with --trace FILE.  Memory stays at the engine's
+//  own footprint however long the run is.
+//
+//    --algo NAME              bubble, merge, quick, tim, ...  (default bubble)
+//    --n N                    elements   (default 1000)
+//    --pattern P              input pattern   (default uniform)
+//    plus --seed, --swaps and the engine options of --bench
+
+// "Parallel Merge" matches parallelmerge, "TimSort" matches tim
+static bool algoNameIs(const char* name, const char* arg)
 {
-    int lx = SW - 210;
-    int ly = BAR_AREA_Y + 14;
-
-    DrawRectangleRounded(
-        { (float)(lx - 10), (float)(ly - 8), 210.f, 90.f },
-        0.12f, 6, { 8, 10, 18, 190 }
-    );
-
-    struct Entry { Color c; const char* label; };
-    Entry entries[] = {
-        { C_BAR_HI, "Default"   },
-        { C_CMP_HI, "Comparing" },
-        { C_SWP_HI, "Swapping"  },
-        { C_SRT_HI, "Sorted"    },
+    auto norm = [](const char* p) {
+        std::string s;
+        for (; *p; p++)
+            if (*p != ' ' && *p != '-') s += (char)std::tolower((unsigned char)*p);
+        if (s.size() > 4 && !s.compare(s.size() - 4, 4, "sort")) s.resize(s.size() - 4);
+        return s;
     };
-
-    for (int i = 0; i < 4; i++) {
-        DrawRectangleRounded(
-            { (float)lx, (float)(ly + i * 20), 14.f, 12.f },
-            0.35f, 4, entries[i].c
-        );
-        DrawText(entries[i].label,
-            lx + 20, ly + i * 20, 14, C_TEXT);
-    }
+    return norm(name) == norm(arg);
 }
 
-static void drawUI(const SortState& s)
+static int runRecord(int argc, char** argv)
 {
-    drawHeader(s);
-    drawButtonRow(s);
-    drawStatsRow(s);
-    drawLegend();
+    const char* path = nullptr;
+    Algorithm algo = BUBBLE;
+    int  n = 1000;
+    EngineOptions opts;
+    InputSpec input;
+    input.seed = 12345;
+
+    for (int i = 1; i < argc; i++) {
+        int run = parseRunArg(argc, argv, i, opts, input);
+        if (run < 0) return 1;
+        if (run) continue;
+        if (!std::strcmp(argv[i], "--record") && i + 1 < argc) {
+            path = argv[++i];
+        }
+        else if (!std::strcmp(argv[i], "--n") && i + 1 < argc) {
+            n = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (!std::strcmp(argv[i], "--algo") && i + 1 < argc) {
+            int k = 0;
+            while (k < ALGO_COUNT && !algoNameIs(ALGO_NAMES[k], argv[i + 1])) k++;
+            if (k == ALGO_COUNT) {
+                std::fprintf(stderr, "unknown algorithm: %s\n", argv[i + 1]);
+                return 1;
+            }
+            algo = (Algorithm)k;
+            i++;
+        }
+        else if (!std::strcmp(argv[i], "--pattern") && i + 1 < argc) {
+            int k = nameIndex("pattern", argv[++i], PAT_NAMES, PAT_COUNT);
+            if (k < 0) return 1;
+            input.pattern = (InputPattern)k;
+        }
+    }
+    if (!path) {
+        std::fprintf(stderr, "--record needs a file name\n");
+        return 1;
+    }
+
+    SortState s;
+    s.algo = algo;
+    s.opts = opts;
+    s.input = input;
+    fillBars(s, n);
+    if (traceTooLarge(s)) {
+        std::fprintf(stderr, "--record: %s records its whole trace in memory "
+            "and is refused at n=%d (%s)\n", ALGO_NAMES[algo], n, refusedLabel(s));
+        return 1;
+    }
+    buildSteps(s);
+
+    TraceHeader h = {};
+    std::memcpy(h.magic, "STRC", 4);
+    h.version = TRACE_VERSION;
+    h.algo = algo;
+    h.n = (uint32_t)n;
+    h.pattern = input.pattern;
+    h.seed = input.seed;
+    h.swaps = input.swaps;
+    h.heapArity = (uint8_t)opts.heapArity;
+    h.pivot = (uint8_t)opts.pivot;
+    h.partition = (uint8_t)opts.partition;
+    h.introDepth = (uint8_t)opts.introDepth;
+    h.introCutoff = opts.introCutoff;
+    h.extRunSize = opts.extRunSize;
+    h.extFanIn = (uint8_t)opts.extFanIn;
+    h.extRunQuick = opts.extRunQuick;
+    h.every = (uint32_t)std::max((long long)TRACE_KEY_MIN, 16LL * n);
+
+    TraceWriter w;
+    if (!w.open(path, h, s.bars)) {
+        std::fprintf(stderr, "%s: cannot write\n", path);
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto t0 = Clock::now();
+    Keyframe k;
+    Op op{};
+    while (s.engine->next(op)) {
+        if (w.wantsKeyframe()) {
+            s.progress = s.engine->progress();
+            snapshot(s, k);
+            w.keyframe(k);
+        }
+        w.event(op);
+        applyOp(s, op);
+        if ((w.count() & ((1 << 26) - 1)) == 0)
+            std::fprintf(stderr, "  %lld events, %.0f%%\n",
+                w.count(), 100.0 * s.engine->progress());
+    }
+    bool ok = w.finish();
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    bool sorted = std::is_sorted(s.bars.begin(), s.bars.end());
+    std::fprintf(stderr, "%s: %s n=%d, %lld events, %.1f MB (%.2f B/event), "
+        "%.1f s%s\n", path, ALGO_NAMES[algo], n, w.count(),
+        w.bytes() / 1e6, w.count() ? (double)w.bytes() / w.count() : 0.0, secs,
+        sorted ? "" : "  NOT SORTED");
+    return ok && sorted ? 0 : 1;
 }
 
 //  Main
 
-int main()
+int main(int argc, char** argv)
 {
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--bench"))
+            return runBench(argc, argv);
+        if (!std::strcmp(argv[i], "--record"))
+            return runRecord(argc, argv);
+        if (!std::strcmp(argv[i], "--gpu-bench"))
+            return runGpuBench(argc, argv);
+    }
+
     SetConfigFlags(FLAG_MSAA_4X_HINT | FLAG_WINDOW_HIGHDPI);
     InitWindow(SW, SH, "Sorting Visualizer — Final");
-    SetTargetFPS(60);
+    SetTargetFPS(TARGET_FPS);
+
+    SortState  s;
+    AnimState  anim;
+    BarLayer   layer;
+
+    // Reproduce a given input:  --pattern P  --seed S
+    // or replay a recorded run:  --trace FILE
+    std::unique_ptr<TraceFile> trace;        // mapped until exit
+    s.input.seed = std::random_device{}() % 100000;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (!std::strcmp(argv[i], "--trace")) {
+            trace = std::make_unique<TraceFile>();
+            if (!trace->open(argv[++i])) {
+                std::fprintf(stderr, "%s: not a readable trace file\n", argv[i]);
+                trace.reset();
+            }
+        }
+        if (!std::strcmp(argv[i], "--seed")) {
+            s.input.seed = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (!std::strcmp(argv[i], "--pattern")) {
+            int k = nameIndex("pattern", argv[++i], PAT_NAMES, PAT_COUNT);
+            if (k < 0) {
+                CloseWindow();
+                return 1;
+            }
+            s.input.pattern = (InputPattern)k;
+        }
+    }
 
-    SortState s;
-    AnimState anim;
+    SortWorker worker;
+    NativeRunner native;
+    TallyTable   tally;
+    ChromeCache  chrome;
+    static FrameProfiler prof;      // ~128 KB of frames, kept off the stack
+    Race       race;
+    Pacer      pace;                // the single run's replay rate
+    GpuBitonic gpu;                 // Bitonic Sort's GPU path, if any
+    bool       scrubbing = false;   // dragging the progress bar
+    bool       waiting = false;     // idle: frames wait for input events
+    s.hist.on = true;
+    s.gpuReady = gpu.init() && gpu.canDraw();
+    layer.rt = LoadRenderTexture(SW, SH);
+    chrome.rt = LoadRenderTexture(SW, SH);
     s.bars.assign(SIZE_OPTIONS[s.sizeIdx], 0);
     s.colorMap.assign(SIZE_OPTIONS[s.sizeIdx], 0);
+    if (trace) attachTrace(s, trace.get());
     shuffle(s, anim);
 
+    // Abandon whatever the worker is doing, then shuffle; while racing
+    // every lane is dealt the new input
+    auto reshuffle = [&]() {
+        if (s.started) s.epoch = worker.drop();
+        s.hist.file = nullptr;               // back to generated input
+        shuffle(s, anim);
+        if (race.on) raceDeal(race, s);
+    };
+
+    // Add or remove a race lane, keeping RACE_MIN..RACE_MAX of them
+    auto toggleLane = [&](int a) {
+        unsigned next = race.roster ^ (1u << a);
+        int k = rosterSize(next);
+        if (k < RACE_MIN || k > RACE_MAX) return;
+        race.roster = next;
+        raceDeal(race, s);
+    };
+
     while (!WindowShouldClose())
     {
-        float dt = GetFrameTime();
+        prof.frame(PH_INPUT);
+        // The first frame after an idle wait spans the whole wait
+        float dt = std::min(GetFrameTime(), 0.1f);
+        bool  busy = s.running || race.running;
 
         // ── Input ─────────
-        for (int i = 0; i < ALGO_COUNT; i++) {
-            if (IsKeyPressed(KEY_ONE + i)) {
+        for (int i = 0; i < ALGO_COUNT && i < 10; i++) {
+            if (IsKeyPressed(i < 9 ? KEY_ONE + i : KEY_ZERO)) {
                 s.algo = (Algorithm)i;
-                shuffle(s, anim);
+                if (!race.on) reshuffle();
+                else if (!busy) toggleLane(i);
+            }
+        }
+        if (IsKeyPressed(KEY_RIGHT) || IsKeyPressed(KEY_LEFT)) {
+            int step = IsKeyPressed(KEY_RIGHT) ? 1 : ALGO_COUNT - 1;
+            s.algo = (Algorithm)((s.algo + step) % ALGO_COUNT);
+            if (!race.on) reshuffle();
+        }
+        if (IsKeyPressed(KEY_ENTER) && race.on && !busy)
+            toggleLane(s.algo);
+
+        // Race mode on / off; the first race defaults to the current
+        // algorithm against Merge, Quick and Heap (or TimSort)
+        if (IsKeyPressed(KEY_V) && !busy) {
+            race.on = !race.on;
+            if (race.on) {
+                if (!race.roster) {
+                    race.roster = 1u << s.algo | 1u << MERGE
+                        | 1u << QUICK | 1u << HEAP;
+                    if (rosterSize(race.roster) < 4) race.roster |= 1u << TIM;
+                }
+                reshuffle();
+            }
+            else {
+                race.lanes.clear();
+                race.started = false;
+                reshuffle();
             }
         }
 
+        // Binary ↔ 4-ary heap (takes effect from the next shuffle)
+        if (IsKeyPressed(KEY_H) && !busy) {
+            s.opts.heapArity = s.opts.heapArity == 2 ? 4 : 2;
+            if (s.algo == HEAP || race.on) reshuffle();
+        }
+
+        // R draws a new input; switching algorithm or options re-runs
+        // the same one, so every algorithm sees identical data
         if (IsKeyPressed(KEY_R)) {
-            shuffle(s, anim);
+            s.input.seed++;
+            reshuffle();
+        }
+
+        // Input pattern (same seed)
+        if (IsKeyPressed(KEY_G) && !busy) {
+            s.input.pattern = (InputPattern)((s.input.pattern + 1) % PAT_COUNT);
+            reshuffle();
+        }
+
+        // Full-speed native run of the current input under the counters
+        if (IsKeyPressed(KEY_N))
+            native.start(s.algo, s.initial, s.opts, s.input.pattern);
+
+        // Frame profiler, and its Chrome trace of the last seconds
+        if (IsKeyPressed(KEY_F)) prof.shown = !prof.shown;
+        if (IsKeyPressed(KEY_X) && prof.shown) {
+            int frames = 0;
+            const char* path = "frame_profile.json";
+            if (prof.exportTrace(path, frames))
+                snprintf(prof.note, sizeof(prof.note), "wrote %s  (%d frames)",
+                    path, frames);
+            else
+                snprintf(prof.note, sizeof(prof.note), "could not write %s", path);
+            prof.noteAt = prof.since();
+        }
+
+        // Comparison table: rebuilt when shown for a different input
+        if (IsKeyPressed(KEY_T) && !race.on) {
+            tally.shown = !tally.shown
+                || !tally.matches(s.input, s.barCount(), s.opts);
+            if (tally.shown && !tally.matches(s.input, s.barCount(), s.opts))
+                tally.start(s.initial, s.input, s.opts);
+        }
+
+        // Quick Sort pivot rule / partition scheme (next shuffle)
+        if ((IsKeyPressed(KEY_P) || IsKeyPressed(KEY_O)) && !busy) {
+            if (IsKeyPressed(KEY_P))
+                s.opts.pivot = (PivotRule)((s.opts.pivot + 1) % PIVOT_COUNT);
+            else
+                s.opts.partition =
+                    (PartitionScheme)((s.opts.partition + 1) % PART_COUNT);
+            if (s.algo == QUICK || race.on) reshuffle();
+        }
+
+        // Intro Sort insertion cutoff / depth factor (next shuffle)
+        if ((IsKeyPressed(KEY_I) || IsKeyPressed(KEY_L)) && !busy) {
+            static const int CUTOFFS[] = { 16, 32, 64, 0, 8 };
+            if (IsKeyPressed(KEY_I)) {
+                int k = 0;
+                while (k < 4 && CUTOFFS[k] != s.opts.introCutoff) k++;
+                s.opts.introCutoff = CUTOFFS[(k + 1) % 5];
+            }
+            else s.opts.introDepth = (s.opts.introDepth + 2) % 3;   // 2 → 1 → 0
+            if (s.algo == INTRO || race.on) reshuffle();
+        }
+
+        // External Sort fan-in / run size / run formation (next shuffle)
+        if ((IsKeyPressed(KEY_K) || IsKeyPressed(KEY_J) || IsKeyPressed(KEY_U))
+            && !busy) {
+            static const int RUN_SIZES[] = { 0, 16, 64, 256, 1024, 4096 };
+            if (IsKeyPressed(KEY_K))
+                s.opts.extFanIn = s.opts.extFanIn >= EXT_FANIN_MAX
+                    ? 2 : s.opts.extFanIn * 2;
+            else if (IsKeyPressed(KEY_J)) {
+                int k = 0;
+                while (k < 5 && RUN_SIZES[k] != s.opts.extRunSize) k++;
+                s.opts.extRunSize = RUN_SIZES[(k + 1) % 6];
+            }
+            else s.opts.extRunQuick = !s.opts.extRunQuick;
+            if (s.algo == EXTERNAL || race.on) reshuffle();
+        }
+
+        // Bitonic Sort on the GPU or the CPU engine (next shuffle)
+        if (IsKeyPressed(KEY_B) && !busy && s.gpuReady) {
+            s.onGpu = !s.onGpu;
+            if (s.algo == BITONIC) reshuffle();
+        }
+
+        // Memory probe counts from the moment it is switched on
+        if (IsKeyPressed(KEY_M)) {
+            s.mem.on = !s.mem.on;
+            s.mem.reset();
         }
 
-        if (IsKeyPressed(KEY_SPACE)) {
-            if (s.finished) {
-                shuffle(s, anim);
+        if (IsKeyPressed(KEY_SPACE) && race.on) {
+            if (race.done()) {
+                s.input.seed++;
+                reshuffle();
             }
             else {
-                if (!s.running && s.steps.empty())
-                    buildSteps(s);
+                if (!race.started) raceStart(race);
+                raceSetRunning(race, !race.running);
+            }
+        }
+        else if (IsKeyPressed(KEY_SPACE)) {
+            if (s.finished && s.hist.file) {
+                seekTo(s, 0);                // a recording plays again
+                anim.fanfareActive = false;
+            }
+            else if (s.finished) {
+                s.input.seed++;
+                reshuffle();
+            }
+            else if (onGpu(s)) {
+                if (!s.started) {
+                    resetRun(s);
+                    gpu.load(s.bars, false);
+                    s.gpuPasses = (int)gpu.passes.size();
+                    s.started = true;
+                }
+                s.running = !s.running;
+            }
+            else if (s.started || !traceTooLarge(s)) {
+                if (!s.running && !s.started) {
+                    resetRun(s);
+                    s.epoch = worker.load(s.algo, s.bars, s.opts, true);
+                    s.started = true;
+                }
                 s.running = !s.running;
+                worker.setRunning(s.running);
+            }
+        }
+
+        // Scrub the replay: drag the progress bar, or step one step
+        // back / forward with , and . while paused (grouped steps land
+        // on multiples of the group)
+        if (!race.on && s.hist.usable()) {
+            Rectangle pb = scrubRect();
+            Vector2   m = GetMousePosition();
+            if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(
+                m, { pb.x - 8, pb.y - 8, pb.width + 16, pb.height + 16 }))
+                scrubbing = true;
+            if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT)) scrubbing = false;
+
+            long long to = s.stepIdx;
+            if (scrubbing) to = scrubTarget(s, m.x);
+            else if (!s.running && IsKeyPressed(KEY_COMMA))
+                to = (to - 1) / s.group() * s.group();
+            else if (!s.running && IsKeyPressed(KEY_PERIOD))
+                to = (to / s.group() + 1) * s.group();
+            if (to != s.stepIdx) {
+                seekTo(s, to);
+                anim.fanfareActive = false;
             }
         }
 
+        if (IsKeyPressed(KEY_C))
+            s.groupIdx = (s.groupIdx + 1) % GROUP_COUNT;
         if (IsKeyPressed(KEY_UP))
-            s.speed = std::min(10, s.speed + 1);
+            s.speed = std::min(SPEED_LEVELS, s.speed + 1);
         if (IsKeyPressed(KEY_DOWN))
             s.speed = std::max(1, s.speed - 1);
 
         // Array size  (only while not sorting)
         if (IsKeyPressed(KEY_D) && s.sizeIdx < SIZE_COUNT - 1
-            && !s.running) {
+            && !busy) {
             s.sizeIdx++;
-            shuffle(s, anim);
+            reshuffle();
         }
         if (IsKeyPressed(KEY_A) && s.sizeIdx > 0
-            && !s.running) {
+            && !busy) {
             s.sizeIdx--;
-            shuffle(s, anim);
+            reshuffle();
         }
 
         // ── Update animations ───────────
-        if (anim.shuffleActive) {
-            anim.shuffleTimer += dt * 1.4f;   // full wave in ~0.7 s
-            if (anim.shuffleTimer >= 1.f)
-                anim.shuffleActive = false;
-        }
-
-        if (anim.fanfareActive) {
-            anim.fanfarePos += dt * s.barCount() * 2.5f;
-            if (anim.fanfarePos > s.barCount() + 6)
-                anim.fanfareActive = false;
-        }
+        prof.enter(PH_ANIM);
+        tickAnim(anim, s.barCount(), dt);
 
         // ── Advance sort steps ─────────────
-        if (s.running && !s.finished) {
-            int spf = (int)std::round(
-                std::pow(2.8f, (s.speed - 1) / 3.0f)
-            );
-            for (int k = 0; k < spf && s.stepIdx < s.steps.size(); k++)
-                s.steps[s.stepIdx++]();
-
-            if (s.stepIdx >= s.steps.size()) {
-                s.running = false;
-                s.finished = true;
-                for (auto& c : s.colorMap) c = 3;
+        prof.enter(PH_STEP);
+        if (s.started && !onGpu(s)
+            && worker.readyEpoch.load(std::memory_order_acquire) == s.epoch) {
+            s.speedup = worker.speedup;
+            s.workers = worker.workers;
+            s.total = worker.tallyEpoch.load(std::memory_order_acquire)
+                == s.epoch ? worker.tally : Tally{};
+            s.arenaBytes = worker.arenaBytes.load(std::memory_order_relaxed);
+            s.arenaAllocs = worker.arenaAllocs.load(std::memory_order_relaxed);
+            if (s.mem.on)
+                s.mem.noteAux(worker.auxBytes.load(std::memory_order_relaxed));
+        }
 
-                // Kick off fanfare sweep
-                anim.fanfareActive = true;
-                anim.fanfarePos = 0.f;
-            }
+        // After a seek back the recorded events play first, then the
+        // worker's queue takes over where the recording ends
+        const History& h = s.hist;
+        if (onGpu(s)) {
+            if (s.running && !s.finished && gpuAdvance(gpu, s, dt))
+                finishRun(s, anim);
         }
+        else if (s.running && !s.finished && !scrubbing) {
+            long long want = pace.grant(s.speed, s.group(), dt);
+            long long before = s.stepIdx;
+            bool end = h.usable() && (s.stepIdx < h.size() || h.complete)
+                ? redoEvents(s, want, pace.budget())
+                : drainEvents(s, worker, want, pace.budget());
+            pace.used(s.stepIdx - before);
+            pace.noteRate(s.stepIdx - before, dt);
+            if (end) finishRun(s, anim);
+        }
+        else {
+            pace.owed = 0;            // nothing banked across a pause
+            if (!s.finished && !scrubbing && h.complete
+                && s.stepIdx == h.size())
+                finishRun(s, anim);   // scrubbed to the end of a done run
+        }
+        if (race.on) raceAdvance(race, s.speed, s.group(), dt, pace.budget());
+        s.etaSec = s.total.valid
+            ? pace.eta(s.speed, s.group(), s.total.events - s.stepIdx) : -1.0;
 
         // ── Draw ──────────────
+        // Timed up to the buffer swap, which waits out the frame
+        auto drawT0 = std::chrono::steady_clock::now();
+        prof.enter(PH_BARS);
+        if (race.on)
+            for (auto& L : race.lanes) updateBarLayer(L->layer, L->s, L->anim);
+        else
+            updateBarLayer(layer, s, anim);
+
         BeginDrawing();
         ClearBackground(C_BG);
-        drawBars(s, anim);
-        drawUI(s);
+        if (!race.on && onGpu(s) && s.started && !s.finished)
+            drawGpuBars(gpu);
+        else if (!race.on) drawBars(layer);
+        {
+            ProfScope ui(prof, PH_UI);
+            updateChrome(chrome, s, race);
+            drawUI(s, race, chrome);
+            drawNativePanel(native);
+            if (!race.on) drawTallyPanel(tally, s);
+            drawProfiler(prof);
+        }
+        pace.noteDraw(std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - drawT0).count());
+
+        // ── Idle ──────────────
+        // Nothing moves until the user does something, so let
+        // EndDrawing() block on the next input event instead of redrawing
+        // at full rate.  Work on other threads whose result would appear
+        // by itself keeps the loop awake until it lands.
+        bool idle = !s.running && !race.running && !scrubbing
+            && !anim.shuffleActive && !anim.fanfareActive
+            && !native.busy() && !tally.busy();
+        for (auto& L : race.lanes)
+            idle = idle && !L->anim.shuffleActive && !L->anim.fanfareActive;
+        if (idle != waiting) {
+            if (idle) EnableEventWaiting();
+            else      DisableEventWaiting();
+            waiting = idle;
+        }
+
+        prof.enter(PH_PRESENT);
         EndDrawing();
     }
 
+    race.lanes.clear();                 // their render textures first
+    UnloadRenderTexture(chrome.rt);
+    UnloadRenderTexture(layer.rt);
+    gpu.unload();
     CloseWindow();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,52 @@
+// Seeking to the end of a history whose length is a multiple of the
+// keyframe spacing K.  recordOp() keys before an event, so that history
+// has size / K keyframes and the last one is K events before the end.
+//
+//   g++ -std=c++17 -pthread -fsanitize=address,undefined tests/seek_boundary.cpp -o seek_boundary $(pkg-config --libs --cflags raylib)
+//   ./seek_boundary
+
+#define main visualizer_main
+#include "../Minor DSA Project/Minor DSA Project.cpp"
+#undef main
+
+// Record `events` of a bubble sort on n bars the way the window does
+static void record(SortState& s, int n, long long events)
+{
+    s.algo = BUBBLE;
+    s.hist.on = true;
+    fillBars(s, n);
+    buildSteps(s);
+    Op op{};
+    for (long long k = 0; k < events && s.engine->next(op); k++) {
+        recordOp(s, op, s.engine->progress());
+        applyOp(s, op);
+        s.stepIdx++;
+    }
+}
+
+int main()
+{
+    int bad = 0;
+    for (long long events : { 2LL * HIST_KEY_MIN, 2LL * HIST_KEY_MIN + 1,
+                              (long long)HIST_KEY_MIN, 1LL }) {
+        SortState s;
+        record(s, 200, events);
+        std::vector<int> bars = s.bars;
+        long long cmp = s.comparisons, swp = s.swaps;
+        long long size = s.hist.size();
+
+        seekTo(s, 0);
+        bool atStart = s.stepIdx == 0 && s.bars == s.initial;
+        seekTo(s, size);
+        bool atEnd = s.stepIdx == size && s.bars == bars
+            && s.comparisons == cmp && s.swaps == swp;
+        seekTo(s, size - 1);
+        seekTo(s, size);                 // one step forward onto the end
+        atEnd = atEnd && s.stepIdx == size && s.bars == bars;
+
+        std::printf("%-6lld events, %zu keyframes: %s\n", size,
+            s.hist.keyCount(), atStart && atEnd ? "ok" : "FAIL");
+        bad += !(atStart && atEnd);
+    }
+    return bad ? 1 : 0;
+}
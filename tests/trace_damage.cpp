@@ -0,0 +1,103 @@
+// Opening and replaying damaged trace files.  open() refuses a file whose
+// header or index does not fit it; a stream or keyframe that fails to
+// decode ends the replay there instead of reading past it.
+//
+//   g++ -std=c++17 -pthread -fsanitize=address,undefined tests/trace_damage.cpp -o trace_damage $(pkg-config --libs --cflags raylib)
+//   ./trace_damage
+
+#define main visualizer_main
+#include "../Minor DSA Project/Minor DSA Project.cpp"
+#undef main
+
+static const char* GOOD = "trace_damage.strace";
+static const char* BAD = "trace_damage_bad.strace";
+
+static std::vector<unsigned char> slurp(const char* path)
+{
+    std::vector<unsigned char> v;
+    if (std::FILE* f = std::fopen(path, "rb")) {
+        int c;
+        while ((c = std::fgetc(f)) != EOF) v.push_back((unsigned char)c);
+        std::fclose(f);
+    }
+    return v;
+}
+
+static void spill(const char* path, const std::vector<unsigned char>& v)
+{
+    std::FILE* f = std::fopen(path, "wb");
+    std::fwrite(v.data(), 1, v.size(), f);
+    std::fclose(f);
+}
+
+static TraceKey keyAt(const std::vector<unsigned char>& v, const TraceHeader& h, int j)
+{
+    TraceKey k;
+    std::memcpy(&k, v.data() + h.indexOffset + j * sizeof(TraceKey), sizeof(k));
+    return k;
+}
+
+// Open the damaged copy and seek to event t, or play it through from
+// the start as the window does when t < 0.  True if the replay stopped
+// at a cut in [lo, hi].
+static bool cutsIn(long long t, long long lo, long long hi)
+{
+    TraceFile f;
+    if (!f.open(BAD)) return false;
+    SortState s;
+    AnimState anim;
+    s.hist.on = true;
+    attachTrace(s, &f);
+    shuffle(s, anim);
+    if (t >= 0) seekTo(s, t);
+    else
+        for (long long k = 0; k <= f.events() && !redoEvents(s, 4096, 1.0); k += 4096) {}
+    return s.hist.cut >= lo && s.hist.cut <= hi && s.stepIdx == s.hist.cut;
+}
+
+int main()
+{
+    const char* av[] = { "x", "--record", GOOD, "--algo", "bubble", "--n", "1000" };
+    if (visualizer_main(7, (char**)av) != 0) return 1;
+    std::vector<unsigned char> good = slurp(GOOD);
+    TraceHeader h;
+    std::memcpy(&h, good.data(), sizeof(h));
+    int bad = 0;
+    auto check = [&bad](const char* what, bool ok) {
+        std::printf("%-34s %s\n", what, ok ? "ok" : "FAIL");
+        bad += !ok;
+    };
+
+    TraceFile f;
+    check("intact file opens", f.open(GOOD) && h.keys >= 6);
+
+    std::vector<unsigned char> v(good.begin(), good.end() - 1);
+    spill(BAD, v);
+    check("truncated file is refused", !f.open(BAD));
+
+    v = good;
+    TraceKey k = keyAt(v, h, 3);
+    k.keyOffset = (uint64_t)v.size() * 2;
+    std::memcpy(v.data() + h.indexOffset + 3 * sizeof(TraceKey), &k, sizeof(k));
+    spill(BAD, v);
+    check("index past the file is refused", !f.open(BAD));
+
+    // Long varints and an unknown kind in the middle of stretch 4
+    v = good;
+    TraceKey k4 = keyAt(v, h, 4), k5 = keyAt(v, h, 5);
+    uint64_t mid = (k4.streamOffset + k5.keyOffset) / 2;
+    std::memset(v.data() + mid, 0xFF, 16);
+    spill(BAD, v);
+    check("damaged events end the replay", cutsIn(-1, 4LL * h.every, 5LL * h.every));
+
+    // A bar colour no replay produces, in keyframe 5
+    v = good;
+    v[k5.keyOffset + (uint64_t)h.n * 4 + 10] = 200;
+    spill(BAD, v);
+    check("damaged keyframe ends the replay", cutsIn(5LL * h.every + 10,
+        5LL * h.every, 5LL * h.every));
+
+    std::remove(GOOD);
+    std::remove(BAD);
+    return bad ? 1 : 0;
+}